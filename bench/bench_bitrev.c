@@ -0,0 +1,83 @@
+/*
+ * Host benchmark: XN297 descramble + bit reversal, per-byte vs 4-bytes-per-step.
+ * Build and run from the project root:
+ *   cc -O2 -Iinclude bench/bench_bitrev.c src/dump_util.c -o bench_bitrev && ./bench_bitrev
+ * "per-byte" is the previous XN297Dump_process_packet work (a scrambled and an
+ * unscrambled bit_reverse copy of every byte) plus the enhanced 2-bit shift.
+ */
+#include "dump_types.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAMES 200000
+#define LEN    30
+
+static const uint8_t scr[40] = {
+	0xE3, 0xB1, 0x4B, 0xEA, 0x85, 0xBC, 0xE5, 0x66, 0x0D, 0xAE, 0x8C, 0x88, 0x12, 0x69,
+	0xEE, 0x1F, 0xC7, 0x62, 0x97, 0xD5, 0x0B, 0x79, 0xCA, 0xCC, 0x1B, 0x5D, 0x19, 0x10,
+	0x24, 0xD3, 0xDC, 0x3F, 0x8E, 0xC5, 0x2F, 0xAA, 0x16, 0xF3, 0x95, 0x00
+};
+
+static void ref_frame(uint8_t *sc, uint8_t *un, uint8_t *en, const uint8_t *p)
+{
+	for (uint8_t i = 0; i < LEN; i++) {
+		sc[i] = bit_reverse(p[i] ^ scr[i]);
+		un[i] = bit_reverse(p[i]);
+		en[i] = bit_reverse((p[i] << 2) | (p[i + 1] >> 6)) ^ bit_reverse((scr[i] << 2) | (scr[i + 1] >> 6));
+	}
+}
+
+static void word_frame(uint8_t *sc, uint8_t *un, uint8_t *en, const uint8_t *p)
+{
+	xn297_descramble_reverse(sc, p, scr, LEN);
+	xn297_descramble_reverse(un, p, NULL, LEN);
+	xn297_descramble_reverse_shift2(en, p, scr, LEN);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+	static uint8_t frames[64][32];
+	uint8_t a[3][LEN], b[3][LEN];
+	uint32_t seed = 0x9E3779B9;
+	for (int f = 0; f < 64; f++)
+		for (int i = 0; i < 32; i++) {
+			seed = seed * 1664525 + 1013904223;
+			frames[f][i] = seed >> 24;
+		}
+
+	for (int f = 0; f < 64; f++) {
+		ref_frame(a[0], a[1], a[2], frames[f]);
+		word_frame(b[0], b[1], b[2], frames[f]);
+		if (memcmp(a, b, sizeof(a))) {
+			printf("MISMATCH on frame %d\n", f);
+			return 1;
+		}
+	}
+
+	volatile uint8_t sink = 0;
+	double t0 = now_ns();
+	for (int n = 0; n < FRAMES; n++) {
+		ref_frame(a[0], a[1], a[2], frames[n & 63]);
+		sink ^= a[0][n % LEN] ^ a[2][n % LEN];
+	}
+	double t1 = now_ns();
+	for (int n = 0; n < FRAMES; n++) {
+		word_frame(b[0], b[1], b[2], frames[n & 63]);
+		sink ^= b[0][n % LEN] ^ b[2][n % LEN];
+	}
+	double t2 = now_ns();
+
+	double ref_ns = (t1 - t0) / FRAMES, word_ns = (t2 - t1) / FRAMES;
+	printf("per-byte   : %8.1f ns/frame\n", ref_ns);
+	printf("4 per step : %8.1f ns/frame\n", word_ns);
+	printf("speedup    : %8.2fx\n", ref_ns / word_ns);
+	return 0;
+}
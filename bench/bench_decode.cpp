@@ -0,0 +1,176 @@
+/*
+ * Host benchmark: XN297 decoder speed and accuracy on the labelled corpus
+ * (include/xn297_corpus.h), the numbers to judge decoder changes by.
+ * Build and run from the project root:
+ *   cc -O2 -Iinclude -c src/xn297_corpus.c src/xn297_decode.c src/dump_util.c &&
+ *   c++ -O2 -Iinclude bench/bench_decode.cpp src/xn297_emu.cpp xn297_corpus.o xn297_decode.o dump_util.o \
+ *     -o bench_decode && ./bench_decode [passes]
+ * xn297_decode() is the promiscuous path (basic and Auto modes). The
+ * XN297_ReadPayload/XN297_ReadEnhancedPayload rows are the XN297 mode path,
+ * fed the bytes the NRF24L01 delivers after matching the frame's address.
+ * det = CRC matched, ok = every field equal to the label, noise det = false
+ * positives. The same corpus runs on the target with 'bench dec'.
+ */
+#include "xn297_corpus.h"
+#include "iface_xn297.h"
+#include "dump_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define DEFAULT_PASSES 50
+
+/* NRF24L01 driver stand-in for xn297_emu.cpp: the RX FIFO is nrf_fifo */
+static const uint8_t *nrf_fifo;
+extern "C" {
+void NRF24L01_ReadPayload(uint8_t *data, uint8_t length) { memcpy(data, nrf_fifo, length); }
+void NRF24L01_Initialize(void) {}
+void NRF24L01_WriteReg(uint8_t, uint8_t) {}
+void NRF24L01_WriteRegisterMulti(uint8_t, uint8_t *, uint8_t) {}
+void NRF24L01_SetBitrate(uint8_t) {}
+void NRF24L01_FlushRx(void) {}
+void NRF24L01_FlushTx(void) {}
+uint8_t NRF24L01_Nop(void) { return 0; }
+uint16_t NRF24L01_RxRetune(uint8_t, uint8_t) { return 0; }
+uint16_t NRF24L01_RxRearm(void) { return 0; }
+void dump_platform_nrf_ce_high(void) {}
+void dump_platform_nrf_ce_low(void) {}
+}
+
+static uint32_t clock_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static uint32_t clock_tsc(void)
+{
+#ifdef HAVE_TSC
+	return (uint32_t)__rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static uint32_t clock_overhead(uint32_t (*clock)(void))
+{
+	uint32_t best = UINT32_MAX;
+	for (int i = 0; i < 16; i++) {
+		uint32_t t0 = clock();
+		uint32_t t = clock() - t0;
+		if (t < best)
+			best = t;
+	}
+	return best;
+}
+
+/* XN297 mode receive path: rows standard/enhanced x unscrambled/scrambled, then the same on noise */
+#define EMU_ROWS 8
+
+static void emu_run(xn297_corpus_result_t *r, uint16_t passes, uint32_t (*clock)(void), uint32_t seed)
+{
+	xn297_corpus_frame_t f;
+	uint8_t fifo[40], msg[32];
+
+	memset(r, 0, sizeof(*r));
+	r->clock_overhead = clock_overhead(clock);
+	nrf_fifo = fifo;
+	while (passes--) {
+		for (uint8_t row = 0; row < EMU_ROWS; row++) {
+			bool noise = row >= 4;
+			f.enhanced = (row >> 1) & 1;
+			f.scramble = row & 1;
+			f.bit_offset = 0;
+			for (f.addr_len = 3; f.addr_len <= 5; f.addr_len++) {
+				uint8_t max = xn297_corpus_max_payload(f.addr_len, f.enhanced, false);
+				for (f.payload_len = 1; f.payload_len <= max; f.payload_len++) {
+					f.kind = XN297_CORPUS_ALIGNED;
+					xn297_corpus_make(&f, &seed);	/* noise rows: label and addr from a real frame */
+					XN297_Configure(XN297_CRCEN, f.scramble, XN297_1M);
+					XN297_SetTXAddr(f.addr, f.addr_len);
+					XN297_SetRXAddr(f.addr, f.payload_len);
+					if (noise) {
+						f.kind = XN297_CORPUS_NOISE;
+						xn297_corpus_make(&f, &seed);
+					}
+					memset(fifo, 0, sizeof(fifo));
+					memcpy(fifo, f.raw + f.addr_len, XN297_RAW_LEN - f.addr_len);
+
+					uint32_t t0 = clock();
+					bool ok;
+					if (f.enhanced)
+						ok = XN297_ReadEnhancedPayload(msg, f.payload_len) == f.payload_len;
+					else
+						ok = XN297_ReadPayload(msg, f.payload_len);
+					uint32_t t = clock() - t0;
+
+					xn297_corpus_score_t *s = &r->row[row];
+					s->frames++;
+					s->ticks += t > r->clock_overhead ? t - r->clock_overhead : 0;
+					s->detected += ok;
+					s->correct += ok && !noise && !memcmp(msg, f.payload, f.payload_len);
+				}
+			}
+		}
+	}
+}
+
+static void print_row(const char *name, const xn297_corpus_score_t *ns, const xn297_corpus_score_t *cy)
+{
+	double n = ns->frames ? ns->frames : 1;
+	printf("%-28s %7lu %7.2f%% %7.2f%% %9.1f %9.1f\n", name, (unsigned long)ns->frames,
+		100.0 * ns->detected / n, 100.0 * ns->correct / n, ns->ticks / n,
+		cy->frames ? (double)cy->ticks / cy->frames : 0.0);
+}
+
+static void print_total(const char *name, const xn297_corpus_result_t *ns, const xn297_corpus_result_t *cy, int rows)
+{
+	xn297_corpus_score_t a = {}, b = {};
+	for (int i = 0; i < rows; i++) {
+		a.frames += ns->row[i].frames;
+		a.detected += ns->row[i].detected;
+		a.correct += ns->row[i].correct;
+		a.ticks += ns->row[i].ticks;
+		b.frames += cy->row[i].frames;
+		b.ticks += cy->row[i].ticks;
+	}
+	print_row(name, &a, &b);
+}
+
+int main(int argc, char **argv)
+{
+	static xn297_corpus_result_t dec_ns, dec_cy, emu_ns, emu_cy;
+	static const char *const fmt[4] = { "standard", "standard scrambled", "enhanced", "enhanced scrambled" };
+	uint16_t passes = argc > 1 ? (uint16_t)atoi(argv[1]) : DEFAULT_PASSES;
+	char name[40];
+
+	/* Same seed for both clocks: identical frames, so the accuracy columns agree */
+	xn297_corpus_run(&dec_ns, passes, clock_ns, 1);
+	xn297_corpus_run(&dec_cy, passes, clock_tsc, 1);
+	emu_run(&emu_ns, passes, clock_ns, 1);
+	emu_run(&emu_cy, passes, clock_tsc, 1);
+
+	printf("%-28s %7s %8s %8s %9s %9s\n", "xn297_decode()", "frames", "det", "ok", "ns", "cycles");
+	for (int row = 0; row < XN297_CORPUS_ROW_NOISE; row++) {
+		snprintf(name, sizeof(name), "%s%s", fmt[row >> 1], row & 1 ? ", shifted" : "");
+		print_row(name, &dec_ns.row[row], &dec_cy.row[row]);
+	}
+	print_total("all frames", &dec_ns, &dec_cy, XN297_CORPUS_ROW_NOISE);
+	print_row("noise (det = false pos.)", &dec_ns.row[XN297_CORPUS_ROW_NOISE], &dec_cy.row[XN297_CORPUS_ROW_NOISE]);
+
+	printf("\n%-28s %7s %8s %8s %9s %9s\n", "XN297_Read(Enhanced)Payload", "frames", "det", "ok", "ns", "cycles");
+	for (int row = 0; row < EMU_ROWS; row++) {
+		snprintf(name, sizeof(name), "%s%s", fmt[row & 3], row >= 4 ? ", noise" : "");
+		print_row(name, &emu_ns.row[row], &emu_cy.row[row]);
+	}
+#ifndef HAVE_TSC
+	printf("(no cycle counter on this host)\n");
+#endif
+	return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Host benchmark: packet line output, one vsnprintf per field/byte (the
+ * previous debug() path) vs the dump_fmt line formatter.
+ * Build and run from the project root:
+ *   cc -O2 -Iinclude bench/bench_fmt.c src/dump_fmt.c -o bench_fmt && ./bench_fmt
+ * Both paths write into the same memory sink standing in for the serial
+ * queue; every line is compared byte for byte before timing.
+ */
+#include "dump_fmt.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINES 200000
+
+static char sink[256];
+static unsigned sink_len;
+
+void dump_platform_write(const uint8_t *buf, uint16_t len)
+{
+	if (sink_len + len > sizeof(sink))
+		len = (uint16_t)(sizeof(sink) - sink_len);
+	memcpy(sink + sink_len, buf, len);
+	sink_len += len;
+}
+
+/* Previous dump_platform_debug/debugln: 128-byte stack buffer, one write per call */
+static void debug(const char *fmt, ...)
+{
+	char buf[128];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (n > (int)sizeof(buf) - 1)
+		n = sizeof(buf) - 1;
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+static void debugln(const char *fmt, ...)
+{
+	char buf[130];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, 128, fmt, ap);
+	va_end(ap);
+	if (n > 127)
+		n = 127;
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+struct frame {
+	uint32_t time;
+	uint8_t  channel, ok, enhanced, pid, ack, scramble, addr_len, len;
+	uint8_t  packet[32];
+};
+
+static void old_line(const struct frame *f)
+{
+	if (f->ok) {
+		debug("RX: %5luus C=%d ", (unsigned long)f->time, f->channel);
+		if (f->enhanced) {
+			debug("Enhanced ");
+			debug("pid=%d ", f->pid);
+			if (f->ack) debug("ack ");
+		}
+		debug("S=%c A=", f->scramble ? 'Y' : 'N');
+		for (uint8_t i = 0; i < f->addr_len; i++)
+			debug(" %02X", f->packet[i]);
+		debug(" P(%d)=", f->len - f->addr_len);
+		for (uint8_t i = f->addr_len; i < f->len; i++)
+			debug(" %02X", f->packet[i]);
+		debugln("");
+	} else {
+		debugln("RX: %5luus C=%d Bad CRC", (unsigned long)f->time, f->channel);
+	}
+}
+
+static void new_line(const struct frame *f)
+{
+	dump_line_t l;
+	fmt_begin(&l);
+	fmt_str(&l, "RX: ");
+	fmt_u(&l, f->time, 5);
+	fmt_str(&l, "us C=");
+	fmt_u(&l, f->channel, 0);
+	if (f->ok) {
+		fmt_char(&l, ' ');
+		if (f->enhanced) {
+			fmt_str(&l, "Enhanced pid=");
+			fmt_u(&l, f->pid, 0);
+			fmt_str(&l, f->ack ? " ack " : " ");
+		}
+		fmt_str(&l, "S=");
+		fmt_char(&l, f->scramble ? 'Y' : 'N');
+		fmt_str(&l, " A=");
+		fmt_hex_bytes(&l, f->packet, f->addr_len);
+		fmt_str(&l, " P(");
+		fmt_u(&l, f->len - f->addr_len, 0);
+		fmt_str(&l, ")=");
+		fmt_hex_bytes(&l, f->packet + f->addr_len, f->len - f->addr_len);
+	} else {
+		fmt_str(&l, " Bad CRC");
+	}
+	fmt_emit(&l, 1);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+	static struct frame frames[1024];
+	char ref[256];
+	unsigned ref_len, bytes = 0;
+
+	srand(1);
+	for (int i = 0; i < 1024; i++) {
+		struct frame *f = &frames[i];
+		f->time = (i & 7) == 0 ? (uint32_t)rand() * 3u : (uint32_t)(rand() % 100000);
+		f->channel = rand() % 85;
+		f->ok = (i % 5) != 0;
+		f->enhanced = rand() & 1;
+		f->pid = rand() & 3;
+		f->ack = rand() & 1;
+		f->scramble = rand() & 1;
+		f->addr_len = 3 + rand() % 3;
+		f->len = f->addr_len + 1 + rand() % (32 - f->addr_len);
+		for (int j = 0; j < 32; j++)
+			f->packet[j] = (uint8_t)rand();
+	}
+
+	for (int i = 0; i < 1024; i++) {
+		sink_len = 0;
+		old_line(&frames[i]);
+		memcpy(ref, sink, sink_len);
+		ref_len = sink_len;
+		sink_len = 0;
+		new_line(&frames[i]);
+		if (sink_len != ref_len || memcmp(ref, sink, ref_len)) {
+			printf("MISMATCH frame %d\n old: %.*s new: %.*s", i, ref_len, ref, sink_len, sink);
+			return 1;
+		}
+		bytes += ref_len;
+	}
+	printf("1024 lines byte-identical, %.1f bytes/line\n", bytes / 1024.0);
+
+	double t0 = now_ns();
+	for (int i = 0; i < LINES; i++) {
+		sink_len = 0;
+		old_line(&frames[i & 1023]);
+	}
+	double t_old = (now_ns() - t0) / LINES;
+	t0 = now_ns();
+	for (int i = 0; i < LINES; i++) {
+		sink_len = 0;
+		new_line(&frames[i & 1023]);
+	}
+	double t_new = (now_ns() - t0) / LINES;
+
+	printf("vsnprintf per field: %8.1f ns/line\n", t_old);
+	printf("dump_fmt line:       %8.1f ns/line  (%.1fx)\n", t_new, t_old / t_new);
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Capture ring: raw RX frames queued between the radio (producer) and
+ * decode/print (consumer). Single producer, single consumer, lock-free:
+ * head is only written by the producer, tail only by the consumer.
+ */
+#ifndef DUMP_CAPTURE_H
+#define DUMP_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DUMP_CAPTURE_SLOTS
+#define DUMP_CAPTURE_SLOTS 16		/* power of two */
+#endif
+#define DUMP_CAPTURE_FRAME_LEN 32
+
+/* dump_frame_t.flags */
+#define DUMP_FRAME_CRC_OK 0x01		/* XN297 mode: CRC checked at capture time */
+#define DUMP_FRAME_CHANNEL 0x02		/* no frame: the radio tuned to channel, printed in order */
+
+typedef struct {
+	uint64_t time;			/* arrival, dump_platform_time_us() */
+	uint32_t queued;		/* committed to the ring, low 32 bits of the same clock */
+	uint8_t  channel;
+	uint8_t  bitrate;
+	uint8_t  len;
+	uint8_t  flags;
+	uint8_t  data[DUMP_CAPTURE_FRAME_LEN];
+} dump_frame_t;
+
+typedef struct {
+	dump_frame_t slot[DUMP_CAPTURE_SLOTS];
+	volatile uint16_t head;		/* next slot to fill */
+	volatile uint16_t tail;		/* next slot to decode */
+	uint16_t peak;			/* most slots ever in use */
+	uint32_t overflow;		/* frames dropped, ring full */
+	uint32_t captured;
+} dump_capture_t;
+
+/*
+ * Per-stage latency in us: radio stage (arrival -> committed), ring wait
+ * (committed -> taken by decode) and decode + output (taken -> released).
+ * capture_* is written by the producer and averaged over
+ * dump_capture.captured, the rest by the consumer over frames.
+ */
+typedef struct {
+	uint32_t frames;
+	uint32_t capture_sum, capture_max;
+	uint32_t wait_sum, wait_max;
+	uint32_t output_sum, output_max;
+	uint32_t depth_sum;		/* ring depth at each take, / frames for the average */
+	uint32_t hold_timeouts;		/* the radio task did not park for the CLI in time */
+} dump_pipe_stats_t;
+
+extern dump_capture_t dump_capture;
+extern dump_pipe_stats_t dump_pipe;
+extern int8_t dump_pipe_core;		/* core running the radio stage task, -1 = single loop */
+
+void dump_capture_reset(void);
+
+static inline void dump_pipe_account(uint32_t *sum, uint32_t *max, uint32_t us)
+{
+	*sum += us;
+	if (us > *max)
+		*max = us;
+}
+
+static inline uint16_t dump_capture_used(void)
+{
+	return (uint16_t)(__atomic_load_n(&dump_capture.head, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&dump_capture.tail, __ATOMIC_ACQUIRE));
+}
+
+/* Producer: slot to fill, NULL (and counted) when full */
+static inline dump_frame_t *dump_capture_claim(void)
+{
+	uint16_t head = dump_capture.head;
+	if ((uint16_t)(head - __atomic_load_n(&dump_capture.tail, __ATOMIC_ACQUIRE)) >= DUMP_CAPTURE_SLOTS) {
+		dump_capture.overflow++;
+		return NULL;
+	}
+	return &dump_capture.slot[head & (DUMP_CAPTURE_SLOTS - 1)];
+}
+
+static inline void dump_capture_commit(void)
+{
+	uint16_t head = (uint16_t)(dump_capture.head + 1);
+	__atomic_store_n(&dump_capture.head, head, __ATOMIC_RELEASE);
+	dump_capture.captured++;
+	uint16_t used = (uint16_t)(head - __atomic_load_n(&dump_capture.tail, __ATOMIC_ACQUIRE));
+	if (used > dump_capture.peak)
+		dump_capture.peak = used;
+}
+
+/* Consumer: oldest frame, NULL when empty */
+static inline const dump_frame_t *dump_capture_peek(void)
+{
+	uint16_t tail = dump_capture.tail;
+	if (__atomic_load_n(&dump_capture.head, __ATOMIC_ACQUIRE) == tail)
+		return NULL;
+	return &dump_capture.slot[tail & (DUMP_CAPTURE_SLOTS - 1)];
+}
+
+static inline void dump_capture_release(void)
+{
+	__atomic_store_n(&dump_capture.tail, (uint16_t)(dump_capture.tail + 1), __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_CAPTURE_H */
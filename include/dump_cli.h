@@ -24,6 +24,9 @@ void cli_process(void);
 /* Print current status */
 void cli_print_status(void);
 
+/* Periodic compact 'stats' line when enabled (call from the main loop) */
+void cli_stats_poll(void);
+
 /* Print help */
 void cli_print_help(void);
 
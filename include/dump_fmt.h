@@ -0,0 +1,41 @@
+/*
+ * Packet line formatter: builds a whole output line in one buffer with
+ * table-driven hex and decimal conversion, then emits it with a single
+ * dump_platform_write(). Output is byte-identical to the printf formats
+ * named next to each helper.
+ */
+#ifndef DUMP_FMT_H
+#define DUMP_FMT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DUMP_FMT_LINE 224	/* longest packet line is ~180 chars */
+
+typedef struct {
+	uint16_t len;
+	char     buf[DUMP_FMT_LINE];
+} dump_line_t;
+
+static inline void fmt_begin(dump_line_t *l)
+{
+	l->len = 0;
+}
+
+void fmt_str(dump_line_t *l, const char *s);
+void fmt_char(dump_line_t *l, char c);
+void fmt_u(dump_line_t *l, uint32_t v, uint8_t width);	/* "%<width>lu", width 0 = "%lu" */
+void fmt_i(dump_line_t *l, int v);				/* "%d" */
+void fmt_hex2(dump_line_t *l, uint8_t v);		/* "%02X" */
+void fmt_hex_bytes(dump_line_t *l, const uint8_t *p, uint8_t n);	/* " %02X" per byte */
+/* Append CRLF (debugln) when crlf, then write the line out */
+void fmt_emit(dump_line_t *l, uint8_t crlf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_FMT_H */
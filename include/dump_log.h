@@ -0,0 +1,59 @@
+/*
+ * Tokenized logging for dump_platform_debug/debugln call sites.
+ *
+ * Built with -DDUMP_LOG_TOKENS, a file that includes this header after
+ * dump_platform.h has its debug calls routed through dump_log(). Each
+ * call carries a compile-time FNV-1a hash of its format literal. In
+ * 'log tok' mode only that ID and the raw arguments are sent, as a
+ * DUMP_REC_LOG record. tools/gen_fmt_table.py builds the ID -> format
+ * table at build time, and tools/xn297dump_decode.py does the
+ * formatting on the host. In 'log text' mode, or without the flag, the
+ * output is the usual text.
+ *
+ * Record payload (framed like dump_output.h records):
+ *   0  u8   DUMP_REC_LOG
+ *   1  u32  format ID
+ *   5  u8   1 = debugln (CRLF appended)
+ *   6  ...  arguments in format order: integers as LEB128 varints
+ *           (signed ones zigzagged), %s as u8 length + bytes
+ * A call whose arguments do not fit one record (DUMP_REC_MAX_LEN) is
+ * sent as text instead, so a record always carries every argument.
+ */
+#ifndef DUMP_LOG_H
+#define DUMP_LOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum DUMP_LOG {
+	DUMP_LOG_MODE_TEXT = 0,
+	DUMP_LOG_MODE_TOKENS = 1,
+};
+
+#define DUMP_REC_LOG 0x02
+
+extern uint8_t dump_log_mode;
+
+void dump_log(uint32_t id, uint8_t nl, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(DUMP_LOG_TOKENS) && defined(__cplusplus)
+/* Must match fnv1a() in tools/gen_fmt_table.py */
+constexpr uint32_t dump_fmt_hash(const char *s, uint32_t h = 2166136261u)
+{
+	return *s ? dump_fmt_hash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+/* Forces compile-time evaluation: the format must be a string literal */
+template <uint32_t ID> struct dump_fmt_id { static const uint32_t value = ID; };
+
+#define dump_platform_debug(fmt, ...)   dump_log(dump_fmt_id<dump_fmt_hash(fmt)>::value, 0, fmt, ##__VA_ARGS__)
+#define dump_platform_debugln(fmt, ...) dump_log(dump_fmt_id<dump_fmt_hash(fmt)>::value, 1, fmt, ##__VA_ARGS__)
+#endif
+
+#endif /* DUMP_LOG_H */
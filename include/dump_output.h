@@ -0,0 +1,67 @@
+/*
+ * Packet output: human-readable text (default) or COBS-framed binary
+ * records for tools/xn297dump_decode.py.
+ *
+ * Binary record, little endian, before COBS encoding:
+ *   0  u8   DUMP_REC_FRAME
+ *   1  u16  sequence number (loss detection)
+ *   3  u32  arrival time, us (low 32 bits of dump_platform_time_us)
+ *   7  u8   sub_protocol
+ *   8  u8   RF channel
+ *   9  u8   bitrate (XN297DUMP_250K/1M/2M)
+ *  10  u8   DUMP_REC_F_* flags, bits 4-7 the bit offset of a re-aligned frame
+ *  11  u8   enhanced PID
+ *  12  u8   address length (0 = data is payload only)
+ *  13  u8   data length
+ *  14  ...  address then payload
+ *  +n  u16  CRC16/CCITT of bytes 0..13+n
+ * Other record types (dump_log.h DUMP_REC_LOG) share the CRC and framing.
+ * Each record is sent as 00 <COBS> 00 so interleaved CLI text never
+ * shares a delimiter-separated chunk with a record.
+ */
+#ifndef DUMP_OUTPUT_H
+#define DUMP_OUTPUT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum DUMP_OUTPUT {
+	DUMP_OUTPUT_TEXT = 0,
+	DUMP_OUTPUT_BINARY = 1,
+};
+
+#define DUMP_REC_FRAME      0x01
+
+#define DUMP_REC_F_CRC_OK   0x01	/* decoded / CRC matched; clear = "Bad CRC" */
+#define DUMP_REC_F_SCRAMBLE 0x02
+#define DUMP_REC_F_ENHANCED 0x04
+#define DUMP_REC_F_ACK      0x08
+#define DUMP_REC_F_OFFSET(o) ((uint8_t)((o) << 4))	/* bits 4-7: xn297_frame_t.bit_offset, 4-bit signed */
+
+#define DUMP_REC_HDR_LEN    14
+#define DUMP_REC_MAX_DATA   32
+#define DUMP_REC_MAX_LEN    (DUMP_REC_HDR_LEN + DUMP_REC_MAX_DATA)	/* any record type, before CRC */
+
+extern uint8_t dump_output_mode;
+
+/* Start a new binary stream: sequence back to 0 */
+void dump_output_reset(void);
+
+void dump_output_frame(uint64_t time, uint8_t channel, uint8_t bitrate, uint8_t flags,
+	uint8_t pid, uint8_t addr_len, const uint8_t *data, uint8_t len);
+
+/* Append the CRC16 to rec (needs 2 spare bytes, len <= DUMP_REC_MAX_LEN)
+ * and send it framed as 00 <COBS> 00 */
+void dump_output_record(uint8_t *rec, uint8_t len);
+
+/* COBS encode len bytes (len <= 254) into out, returns the encoded length (len + 1) */
+uint8_t cobs_encode(uint8_t *out, const uint8_t *in, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_OUTPUT_H */
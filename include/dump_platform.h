@@ -16,31 +16,71 @@ extern "C" {
 void dump_platform_debug_init(void);
 void dump_platform_debug(const char *fmt, ...);
 void dump_platform_debugln(const char *fmt, ...);
+/* Raw bytes to the same port (binary output mode) */
+void dump_platform_write(const uint8_t *buf, uint16_t len);
+/* All output goes through dump_txq; kick the background drain (call from the main loop) */
+void dump_platform_tx_poll(void);
+/* Wait until the TX queue and the UART/USB driver's own buffer are on the wire ('tput' and 'stats', blocks) */
+void dump_platform_tx_flush(void);
+
+/* CLI/output transport. USB only on ESP32-S3 builds with ARDUINO_USB_CDC_ON_BOOT. */
+enum DUMP_PORT {
+	DUMP_PORT_UART = 0,
+	DUMP_PORT_USB  = 1,
+};
+int  dump_platform_set_port(uint8_t port);	/* 1 if switched, 0 if not available */
+const char *dump_platform_port_name(void);
 
 /* Serial input for CLI */
 int  dump_platform_serial_available(void);
 int  dump_platform_serial_read(void);
 void dump_platform_serial_read_line(char *buf, int maxlen);
 
-/* Timer used for packet timing. Units: 0.5us (2MHz). */
+/* Packet timing: monotonic microseconds from a free-running hardware timer, no polling needed */
 void dump_platform_timer_init(void);
-uint32_t dump_platform_timer_get_us(void);   /* full 32-bit time (0.5us units) */
-uint16_t dump_platform_timer_get_cnt(void);  /* low 16 bits (like TCNT1) */
-/* Returns 1 if 16-bit counter wrapped since last call. Call each loop. */
-int dump_platform_timer_overflow(void);
+uint64_t dump_platform_time_us(void);
+/* CPU cycle counter (DWT CYCCNT / CCOUNT), started by timer_init; wraps, use differences */
+uint32_t dump_platform_cycles(void);
+uint32_t dump_platform_cpu_hz(void);
 
 /* SPI and NRF24L01 pins */
 void dump_platform_spi_init(void);
-void dump_platform_spi_write(uint8_t byte);
+uint8_t dump_platform_spi_write(uint8_t byte);	/* returns the byte clocked in */
 uint8_t dump_platform_spi_read(void);
+/* Burst transfer: tx NULL clocks out 0xFF, rx NULL discards (DMA / hardware FIFO backed) */
+void dump_platform_spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len);
+/* Fastest rate not above hz; returns the rate actually set */
+uint32_t dump_platform_spi_set_clock(uint32_t hz);
+const char *dump_platform_spi_backend(void);	/* name of the SPI/GPIO path, for 'bench' */
 
 void dump_platform_nrf_csn_high(void);
 void dump_platform_nrf_csn_low(void);
 void dump_platform_nrf_ce_high(void);
 void dump_platform_nrf_ce_low(void);
+/* 0 when CE is tied high on the board instead of driven by a GPIO */
+int  dump_platform_nrf_has_ce(void);
+
+/* Optional NRF IRQ pin (active low). NRF_IRQ_PIN < 0 = not wired, callers poll STATUS. */
+int  dump_platform_nrf_irq_init(void);               /* 1 if wired and the falling edge is armed */
+int  dump_platform_nrf_irq_asserted(void);           /* 1 while the pin is low (STATUS flag pending) */
+int  dump_platform_nrf_irq_take(uint64_t *stamp);    /* 1 if an edge was latched since the last call; stamp in time_us units */
 
 void dump_platform_delay_us(unsigned int us);
 
+/*
+ * Radio stage on its own core (ESP32-S3 with -DDUMP_DUAL_CORE): calls step
+ * forever from a task pinned to the core the main loop is not on, sleeping
+ * a tick whenever it returns 0. Returns that core, or -1 when the build has
+ * a single loop (the caller then runs the radio stage itself).
+ */
+int  dump_platform_capture_task_start(int (*step)(void));
+/* From step: sleep until the main loop calls dump_platform_capture_task_wake() */
+void dump_platform_capture_task_park(void);
+void dump_platform_capture_task_wake(void);
+/* From step: tell the main loop it parked or resumed */
+void dump_platform_capture_task_ack(void);
+int  dump_platform_capture_task_wait_ack(uint32_t timeout_ms);	/* 1 if acknowledged, 0 on timeout */
+
 #ifdef __cplusplus
 }
 #endif
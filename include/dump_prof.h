@@ -0,0 +1,73 @@
+/*
+ * Cycle profiler zones (build with -DDUMP_PROF, 'prof' CLI command).
+ *
+ * Each zone counts calls, total and max CPU cycles from
+ * dump_platform_cycles() (DWT CYCCNT on STM32, CCOUNT on ESP32-S3).
+ * Zones nest and totals are inclusive: loop contains radio and drain,
+ * radio contains spi, drain contains decode. settle is not CPU time:
+ * it is how long the radio was deaf in PLL/RX settle periods.
+ * Without DUMP_PROF the macros expand to nothing and no data is kept.
+ */
+#ifndef DUMP_PROF_H
+#define DUMP_PROF_H
+
+#include <stdint.h>
+#include "dump_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum DUMP_PROF_ZONE {
+	DUMP_PROF_LOOP = 0,	/* one pass of the main loop */
+	DUMP_PROF_RADIO,	/* radio stage step (Auto mode also decodes and prints here) */
+	DUMP_PROF_SPI,		/* NRF24L01 transaction, CSN low to high */
+	DUMP_PROF_SETTLE,	/* RX settle period, start to NRF24L01_RxReady() */
+	DUMP_PROF_DRAIN,	/* decode + format + queue of one captured frame */
+	DUMP_PROF_DECODE,	/* xn297_decode() */
+	DUMP_PROF_TX,		/* dump_platform_tx_poll() */
+	DUMP_PROF_CLI,		/* cli_process() */
+	DUMP_PROF_ZONES
+};
+
+typedef struct {
+	uint32_t start;		/* cycles at the open DUMP_PROF_BEGIN */
+	uint32_t calls;
+	uint32_t max;
+	uint64_t cycles;
+} dump_prof_zone_t;
+
+#ifdef DUMP_PROF
+extern dump_prof_zone_t dump_prof[DUMP_PROF_ZONES];
+extern uint64_t dump_prof_since;	/* dump_platform_time_us() of the last reset */
+
+void dump_prof_reset(void);
+
+/* A zone is open at most once at a time (zones do not recurse) */
+static inline void dump_prof_begin(uint8_t zone)
+{
+	dump_prof[zone].start = dump_platform_cycles();
+}
+
+static inline void dump_prof_end(uint8_t zone)
+{
+	dump_prof_zone_t *z = &dump_prof[zone];
+	uint32_t c = dump_platform_cycles() - z->start;
+	z->calls++;
+	z->cycles += c;
+	if (c > z->max)
+		z->max = c;
+}
+
+#define DUMP_PROF_BEGIN(zone) dump_prof_begin(zone)
+#define DUMP_PROF_END(zone)   dump_prof_end(zone)
+#else
+#define DUMP_PROF_BEGIN(zone) ((void)0)
+#define DUMP_PROF_END(zone)   ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_PROF_H */
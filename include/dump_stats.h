@@ -0,0 +1,69 @@
+/*
+ * Capture statistics, always on: where frames are lost on a busy bench
+ * (RF, SPI/FIFO or serial). Counted since boot or 'stats reset', shown by
+ * the 'stats' CLI command. Counters are plain increments, no locking. In
+ * the dual-core build the CRC and decode counters are written by both
+ * cores (Auto mode decodes in the radio task, the other modes in the main
+ * loop), so a rare count may be lost, and a report read while the radio
+ * task runs may be a few counts apart between fields.
+ */
+#ifndef DUMP_STATS_H
+#define DUMP_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DUMP_STATS_CHANNELS 85		/* 0..84, the channels the dump tunes */
+#define DUMP_STATS_BITRATES 3		/* XN297DUMP_250K, _1M, _2M */
+
+typedef struct {
+	uint64_t since;			/* dump_platform_time_us() of the last reset */
+	uint32_t loops;			/* main loop passes */
+	uint32_t rx_dr;			/* polls that found RX_DR set (or the IRQ pin low) */
+	uint32_t rpd_low;		/* ... with RPD low: the scans leave those frames */
+	uint32_t fifo_full;		/* RX_DR that found all 3 RX FIFO levels used: later frames lost */
+	uint32_t retunes;		/* RF channel changes */
+	uint32_t sweeps;		/* scans through every channel (250K/1M/2M scan, Auto phases 1-2) */
+	uint32_t decodes;
+	uint32_t decode_max;		/* cycles */
+	uint64_t decode_cycles;
+	uint32_t txq_queued0;		/* dump_txq counters at the last reset */
+	uint32_t txq_dropped0;
+	uint32_t txq_dropped_bytes0;
+	uint32_t crc_ok[DUMP_STATS_BITRATES][DUMP_STATS_CHANNELS];
+	uint32_t crc_bad[DUMP_STATS_BITRATES][DUMP_STATS_CHANNELS];
+} dump_stats_t;
+
+extern dump_stats_t dump_stats;
+
+void dump_stats_reset(void);
+/* Sum of crc_ok and crc_bad over every channel and bitrate */
+void dump_stats_crc_totals(uint32_t *ok, uint32_t *bad);
+
+static inline void dump_stats_crc(uint8_t channel, uint8_t bitrate, bool ok)
+{
+	if (bitrate >= DUMP_STATS_BITRATES || channel >= DUMP_STATS_CHANNELS)
+		return;
+	if (ok)
+		dump_stats.crc_ok[bitrate][channel]++;
+	else
+		dump_stats.crc_bad[bitrate][channel]++;
+}
+
+static inline void dump_stats_decode(uint32_t cycles)
+{
+	dump_stats.decodes++;
+	dump_stats.decode_cycles += cycles;
+	if (cycles > dump_stats.decode_max)
+		dump_stats.decode_max = cycles;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_STATS_H */
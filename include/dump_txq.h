@@ -0,0 +1,67 @@
+/*
+ * Serial transmit queue: every text line and binary record goes through
+ * this byte ring, and the platform drains it in the background (DMA on
+ * STM32, UART driver top-ups on ESP32). Writers never block: a message
+ * that does not fit is dropped whole and counted.
+ * There is no separate flush-on-idle step: every write kicks the drain and
+ * the main loop polls it each pass (the STM32 DMA ISR also chains the next
+ * chunk itself), so the port never idles with bytes queued.
+ * Single producer (main loop), single consumer (drain / DMA ISR).
+ */
+#ifndef DUMP_TXQ_H
+#define DUMP_TXQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DUMP_TXQ_SIZE
+#define DUMP_TXQ_SIZE 4096		/* power of two, <= 32768 */
+#endif
+
+typedef struct {
+	uint8_t  buf[DUMP_TXQ_SIZE];
+	volatile uint16_t head;		/* written by the producer */
+	volatile uint16_t tail;		/* written by the consumer */
+	uint16_t peak;			/* high-water mark, bytes */
+	uint32_t queued;		/* bytes accepted, not yet necessarily on the wire */
+	uint32_t dropped;		/* messages dropped, queue full */
+	uint32_t dropped_bytes;
+} dump_txq_t;
+
+extern dump_txq_t dump_txq;
+
+/* Queue all len bytes or none; false (and counted) when it does not fit */
+bool dump_txq_write(const void *data, uint16_t len);
+
+static inline uint16_t dump_txq_used(void)
+{
+	return (uint16_t)(__atomic_load_n(&dump_txq.head, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&dump_txq.tail, __ATOMIC_ACQUIRE));
+}
+
+/* Consumer: contiguous bytes ready at the tail (up to the wrap point) */
+static inline uint16_t dump_txq_linear(const uint8_t **p)
+{
+	uint16_t tail = dump_txq.tail;
+	uint16_t used = (uint16_t)(__atomic_load_n(&dump_txq.head, __ATOMIC_ACQUIRE) - tail);
+	uint16_t off = tail & (DUMP_TXQ_SIZE - 1);
+	if (used > DUMP_TXQ_SIZE - off)
+		used = DUMP_TXQ_SIZE - off;
+	*p = &dump_txq.buf[off];
+	return used;
+}
+
+static inline void dump_txq_consume(uint16_t n)
+{
+	__atomic_store_n(&dump_txq.tail, (uint16_t)(dump_txq.tail + n), __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DUMP_TXQ_H */
@@ -31,15 +31,38 @@ extern uint8_t  rf_ch_num;
 extern uint8_t  rx_tx_addr[5];
 extern uint16_t bind_counter;
 extern uint8_t  phase;
-extern uint16_t crc;
-extern uint16_t crc16_polynomial;
 
 /* NRF24L01 */
 extern uint8_t  prev_power;
+extern uint32_t rx_fifo_recovered;	/* extra frames drained from the RX FIFO after RX_DR, this run */
 
 /* Helpers (implemented in dump_util.c or main) */
 uint8_t  bit_reverse(uint8_t b_in);
-void     crc16_update(uint8_t a, uint8_t bits);
+
+/* Table-driven CRC16/CCITT (poly 0x1021), state passed explicitly */
+extern const uint16_t crc16_ccitt_table[256];
+static inline uint16_t crc16_ccitt_byte(uint16_t c, uint8_t a)
+{
+	return (uint16_t)(c << 8) ^ crc16_ccitt_table[(uint8_t)(c >> 8) ^ a];
+}
+/* Top 2 bits of a only (XN297 enhanced PCF tail) */
+static inline uint16_t crc16_ccitt_2bits(uint16_t c, uint8_t a)
+{
+	c ^= (uint16_t)(a & 0xC0) << 8;
+	c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+	c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+	return c;
+}
+uint16_t crc16_ccitt_block(uint16_t c, const uint8_t *data, uint8_t len);
+
+/* out[i] = bit_reverse(in[i] ^ scramble[i]); scramble may be NULL. In-place safe. */
+void xn297_descramble_reverse(uint8_t *out, const uint8_t *in, const uint8_t *scramble, uint8_t len);
+/* Enhanced payload, 2 bits behind the byte boundary: reads len + 1 bytes of in/scramble */
+void xn297_descramble_reverse_shift2(uint8_t *out, const uint8_t *in, const uint8_t *scramble, uint8_t len);
+
+/* Re-align a received bit stream by k = 1..7 bits (in-place safe) */
+void bitstream_shift_left(uint8_t *out, const uint8_t *in, uint8_t len, uint8_t k);
+void bitstream_shift_right(uint8_t *out, const uint8_t *in, uint8_t len, uint8_t k, uint8_t fill);
 
 /* Stubs for multiprotocol compatibility */
 #define BIND_DONE
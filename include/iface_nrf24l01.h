@@ -6,6 +6,7 @@
 #define IFACE_NRF24L01_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifndef _BV
 #define _BV(bit) (1 << (bit))
@@ -59,6 +60,8 @@ enum {
     NRF24L01_07_RX_DR       = 6,
     NRF24L01_07_TX_DS       = 5,
     NRF24L01_07_MAX_RT      = 4,
+    NRF24L01_07_RX_P_NO     = 1,    /* 3 bits, 7 = RX FIFO empty */
+    NRF24L01_17_RX_EMPTY    = 0,
 };
 
 enum {
@@ -76,15 +79,32 @@ enum {
 #define FLUSH_TX      0xE1
 #define FLUSH_RX      0xE2
 
+/* STATUS.RX_P_NO value when the RX FIFO is empty */
+#define NRF24L01_RX_P_NO_EMPTY 0x07
+
+/* Settle times (us): standby -> RX, and power down -> standby */
+#define NRF24L01_SETTLE_RX_US     130
+#define NRF24L01_SETTLE_PWR_UP_US 1500
+
+/* SPI clock autotune range (Hz); the datasheet limit is 10 MHz */
+#define NRF24L01_SPI_HZ_MIN       1000000UL
+#define NRF24L01_SPI_HZ_MAX       10000000UL
+#define NRF24L01_SPI_TUNE_PASSES  16
+
 /* NRF24L01 driver (implemented in nrf24l01.cpp) */
 #ifdef __cplusplus
 extern "C" {
 #endif
 void NRF24L01_Initialize(void);
 void NRF24L01_WriteReg(uint8_t reg, uint8_t data);
+/* Skips the SPI write if the register already holds data; returns 1 if written */
+uint8_t NRF24L01_WriteRegCached(uint8_t reg, uint8_t data);
 void NRF24L01_WriteRegisterMulti(uint8_t reg, uint8_t *data, uint8_t length);
 void NRF24L01_ReadRegisterMulti(uint8_t reg, uint8_t *data, uint8_t length);
 uint8_t NRF24L01_ReadReg(uint8_t reg);
+/* STATUS as clocked out by the last SPI command, and a 1-byte NOP poll of it */
+uint8_t NRF24L01_LastStatus(void);
+uint8_t NRF24L01_Nop(void);
 void NRF24L01_ReadPayload(uint8_t *data, uint8_t length);
 void NRF24L01_WritePayload(uint8_t *data, uint8_t length);
 void NRF24L01_FlushTx(void);
@@ -93,8 +113,18 @@ void NRF24L01_SetBitrate(uint8_t bitrate);
 void NRF24L01_SetPower(void);
 void NRF24L01_SetTxRxMode(enum TXRX_State mode);
 
+/* Fast RX path, chip stays powered up. Return the settle time started in us. */
+uint16_t NRF24L01_RxRetune(uint8_t channel, uint8_t config);
+uint16_t NRF24L01_RxRearm(void);
+uint16_t NRF24L01_LastSettle(void);
+/* False until the settle started by SetTxRxMode/RxRetune has elapsed (non-blocking) */
+bool NRF24L01_RxReady(void);
+
 /* Detection: returns 1 if NRF24L01 detected, 0 otherwise */
 uint8_t NRF24L01_Detect(void);
+/* Step the SPI clock up from NRF24L01_SPI_HZ_MIN while Detect() keeps passing; returns the rate kept (0 if none) */
+uint32_t NRF24L01_SpiAutotune(void);
+uint32_t NRF24L01_SpiClock(void);
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,8 @@ void XN297_Configure(bool crc_en, bool scramble_en, bool bitrate, bool force_nrf
 void XN297_SetTXAddr(const uint8_t *addr, uint8_t len);
 void XN297_SetRXAddr(const uint8_t *addr, uint8_t rx_packet_len);
 void XN297_SetTxRxMode(enum TXRX_State mode);
+void XN297_RxRetune(uint8_t number);
+void XN297_RxRearm(void);
 bool XN297_IsRX(void);
 bool XN297_ReadPayload(uint8_t *msg, uint8_t len);
 uint8_t XN297_ReadEnhancedPayload(uint8_t *msg, uint8_t len);
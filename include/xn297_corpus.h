@@ -0,0 +1,82 @@
+/*
+ * Labelled XN297 frame corpus for measuring the decoder: valid frames in
+ * every format (standard/enhanced, scrambled or not, address 3..5, every
+ * payload length that fits the 32-byte FIFO), the same frames off the byte
+ * grid by 1..7 bits either way, and noise. The decoder first sees the
+ * shifted frame's transmitter send at the same offset until it is found,
+ * as one that always lands off the grid would, and an on-grid frame
+ * before each noise frame. Used by bench/bench_decode.cpp on the host and
+ * by 'bench dec' on the target.
+ */
+#ifndef XN297_CORPUS_H
+#define XN297_CORPUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "xn297_decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum XN297_CORPUS_KIND {
+	XN297_CORPUS_ALIGNED = 0,
+	XN297_CORPUS_SHIFTED = 1,	/* bit_offset != 0 */
+	XN297_CORPUS_NOISE   = 2,
+};
+
+/* Score rows: (enhanced << 2) | (scramble << 1) | shifted, then noise */
+#define XN297_CORPUS_ROW(enh, scr, shifted) (((enh) << 2) | ((scr) << 1) | (shifted))
+#define XN297_CORPUS_ROW_NOISE 8
+#define XN297_CORPUS_ROWS      9
+#define XN297_CORPUS_NOISE_PER_PASS 256
+
+typedef struct {
+	uint8_t raw[XN297_RAW_LEN];	/* as read from the RX FIFO on the 55 0F 71 address */
+	uint8_t prime[XN297_RAW_LEN];	/* decoded first: shifted = an earlier frame of the same transmitter, noise = an on-grid frame */
+	uint8_t kind;
+	uint8_t addr_len;
+	uint8_t payload_len;
+	bool    scramble;
+	bool    enhanced;
+	uint8_t pid;
+	bool    ack;
+	int8_t  bit_offset;		/* the decoder's convention: >0 late, <0 early */
+	uint8_t addr[5];		/* MSB first */
+	uint8_t payload[32];
+} xn297_corpus_frame_t;
+
+typedef struct {
+	uint32_t frames;
+	uint32_t detected;		/* xn297_decode() returned true */
+	uint32_t correct;		/* ... and every field matched the label */
+	uint64_t ticks;			/* clock units spent in xn297_decode(), overhead removed */
+} xn297_corpus_score_t;
+
+typedef struct {
+	xn297_corpus_score_t row[XN297_CORPUS_ROWS];
+	uint32_t clock_overhead;	/* min ticks between two back-to-back clock() reads */
+} xn297_corpus_result_t;
+
+/* Longest payload of a format that still fits the FIFO (with room for a 7-bit shift) */
+uint8_t xn297_corpus_max_payload(uint8_t addr_len, bool enhanced, bool shifted);
+
+/*
+ * Fill raw, prime and the random fields (addr, payload, pid, ack) of f.
+ * kind, addr_len, payload_len, scramble, enhanced and bit_offset are set
+ * by the caller, for noise too (they shape prime). seed is a plain LCG
+ * state, so a corpus is the same on every build.
+ */
+void xn297_corpus_make(xn297_corpus_frame_t *f, uint32_t *seed);
+
+/* true when a decoded frame matches the label in every field */
+bool xn297_corpus_check(const xn297_corpus_frame_t *f, const xn297_frame_t *d);
+
+/* One pass = every format/address/length aligned and shifted, plus XN297_CORPUS_NOISE_PER_PASS noise frames */
+void xn297_corpus_run(xn297_corpus_result_t *r, uint16_t passes, uint32_t (*clock)(void), uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XN297_CORPUS_H */
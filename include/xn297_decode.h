@@ -0,0 +1,60 @@
+/*
+ * XN297 frame decoder. Takes a raw frame received on the promiscuous
+ * 55 0F 71 address and matches the CRC at every candidate length to find
+ * the address/payload split, the scrambling and the standard/enhanced
+ * format. A frame that fails on the byte grid is re-aligned where the
+ * address of the last frame shows up 1..7 bits off, and then must match
+ * that frame's format (and length, for standard frames). Without such a
+ * match, late offsets are tried where raw starts with the sync byte's
+ * tail, and one early offset per frame.
+ * All state is in xn297_decoder_t: use one per concurrent caller.
+ */
+#ifndef XN297_DECODE_H
+#define XN297_DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XN297_RAW_LEN   32	/* raw frame as read from the NRF24L01 RX FIFO */
+#define XN297_CRC_LEN   2
+#define XN297_SYNC_TAIL 0x55	/* last on-air byte of the 55 0F 71 promiscuous address */
+
+/* Decoded frame: addr/payload point into the decoder, valid until its next xn297_decode() */
+typedef struct {
+	const uint8_t *addr;	/* MSB first */
+	const uint8_t *payload;	/* descrambled, bit order restored */
+	uint8_t addr_len;
+	uint8_t payload_len;
+	bool    scramble;
+	bool    enhanced;
+	uint8_t pid;		/* enhanced only */
+	bool    ack;		/* enhanced only */
+	int8_t  bit_offset;	/* bits the frame was off the byte boundary, <0 = early */
+} xn297_frame_t;
+
+typedef struct {
+	uint8_t  addr_len;			/* configured address length, 3..5 */
+	uint32_t offset_recovered;		/* frames only decoded after re-alignment */
+	uint8_t  learned_len;			/* address bytes of the last frame decoded, 0 = none yet */
+	uint8_t  learned_addr[5];		/* ... as on air (scrambled if it was) */
+	uint8_t  learned_frame_len;		/* ... address + payload */
+	bool     learned_enhanced;
+	uint8_t  search_early;			/* early offset the next first-detection search tries, 1..7 */
+	uint8_t  out[XN297_RAW_LEN];		/* address + payload of the last frame */
+	uint8_t  shifted[XN297_RAW_LEN];	/* re-aligned copy of the input */
+} xn297_decoder_t;
+
+void xn297_decoder_init(xn297_decoder_t *d, uint8_t addr_len);
+
+/* raw is XN297_RAW_LEN bytes and left untouched; true and *f filled when a CRC matched */
+bool xn297_decode(xn297_decoder_t *d, const uint8_t *raw, xn297_frame_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XN297_DECODE_H */
@@ -0,0 +1,16 @@
+/*
+ * Capture ring storage (see dump_capture.h).
+ */
+#include "../include/dump_capture.h"
+#include <string.h>
+
+dump_capture_t dump_capture;
+dump_pipe_stats_t dump_pipe;
+int8_t dump_pipe_core = -1;
+
+/* Only while neither side is running (init/restart) */
+void dump_capture_reset(void)
+{
+	memset(&dump_capture, 0, sizeof(dump_capture));
+	memset(&dump_pipe, 0, sizeof(dump_pipe));
+}
@@ -9,17 +9,34 @@
  *   start             - start dumping
  *   stop              - stop dumping
  *   restart           - restart with current settings
+ *   bench             - time NRF24L01 register access (dump must be stopped)
+ *   bench dec [n]     - decoder cycles/frame and accuracy on n passes of the frame corpus
+ *   out <text|bin>    - packet output format (bin = COBS records, tools/xn297dump_decode.py)
+ *   port <uart|usb>   - CLI/output transport (usb on ESP32-S3 USB builds)
+ *   tput [s]          - stream synthetic binary records for s seconds, report bytes/s
+ *   log <text|tok>    - CLI/status messages as text or tokenized records (DUMP_LOG_TOKENS builds)
+ *   prof              - per-zone calls and cycles since the last 'prof', then reset (DUMP_PROF builds)
+ *   stats [s|reset]   - capture statistics; s > 0 also prints a compact line every s seconds, 0 stops it
  */
 #include "../include/dump_cli.h"
 #include "../include/dump_config.h"
 #include "../include/dump_platform.h"
 #include "../include/dump_types.h"
+#include "../include/dump_capture.h"
+#include "../include/dump_output.h"
+#include "../include/dump_txq.h"
+#include "../include/dump_log.h"
+#include "../include/dump_prof.h"
+#include "../include/dump_stats.h"
 #include "../include/iface_nrf24l01.h"
+#include "../include/xn297_corpus.h"
 #include <string.h>
 #include <stdlib.h>
 
 #define CLI_BUF_SIZE 64
 
+extern uint32_t XN297Dump_offset_recovered(void);
+
 volatile bool cli_dump_running = false;
 static volatile bool s_restart_requested = false;
 static char s_cmd_buf[CLI_BUF_SIZE];
@@ -42,6 +59,14 @@ void cli_print_help(void)
 	dump_platform_debugln("  start             - start dumping");
 	dump_platform_debugln("  stop              - stop dumping");
 	dump_platform_debugln("  restart           - restart with current settings");
+	dump_platform_debugln("  bench             - time NRF24L01 register access");
+	dump_platform_debugln("  bench dec [n]     - decoder cycles/frame + accuracy (n passes)");
+	dump_platform_debugln("  out <text|bin>    - packet output format");
+	dump_platform_debugln("  port <uart|usb>   - CLI/output transport");
+	dump_platform_debugln("  tput [s]          - output throughput test (default 5s)");
+	dump_platform_debugln("  log <text|tok>    - message format (tok = IDs, decode on host)");
+	dump_platform_debugln("  prof              - cycle profile per zone, then reset");
+	dump_platform_debugln("  stats [s|reset]   - capture statistics (s: compact line every s seconds, 0 = off)");
 	dump_platform_debugln("");
 }
 
@@ -53,6 +78,8 @@ void cli_detect_nrf(void)
 	s_nrf_detected = NRF24L01_Detect();
 	if (s_nrf_detected) {
 		dump_platform_debugln("FOUND");
+		NRF24L01_SpiAutotune();
+		dump_platform_debugln("SPI clock: %lu kHz", (unsigned long)(NRF24L01_SpiClock() / 1000));
 	} else {
 		dump_platform_debugln("NOT FOUND");
 		dump_platform_debugln("  Check SPI wiring: MOSI, MISO, SCK, CSN");
@@ -80,9 +107,267 @@ void cli_print_status(void)
 	
 	dump_platform_debugln("  Addr len (RX_num):   %d", RX_num);
 	dump_platform_debugln("  Dump running:        %s", cli_dump_running ? "YES" : "NO");
+	dump_platform_debugln("  Output:              %s on %s", dump_output_mode == DUMP_OUTPUT_BINARY ? "bin" : "text",
+		dump_platform_port_name());
+	dump_platform_debugln("  Log:                 %s", dump_log_mode == DUMP_LOG_MODE_TOKENS ? "tok" : "text");
+	dump_platform_debugln("  TX queue:            %u/%u bytes, peak %u, %lu queued, %lu dropped (%lu bytes)",
+		dump_txq_used(), DUMP_TXQ_SIZE, dump_txq.peak, (unsigned long)dump_txq.queued,
+		(unsigned long)dump_txq.dropped, (unsigned long)dump_txq.dropped_bytes);
+	dump_platform_debugln("  FIFO frames drained: %lu", (unsigned long)rx_fifo_recovered);
+	dump_platform_debugln("  Capture ring:        %u/%u used, peak %u, %lu captured, %lu overflows",
+		dump_capture_used(), DUMP_CAPTURE_SLOTS, dump_capture.peak,
+		(unsigned long)dump_capture.captured, (unsigned long)dump_capture.overflow);
+	if (dump_pipe_core < 0)
+		dump_platform_debugln("  Pipeline:            single loop");
+	else
+		dump_platform_debugln("  Pipeline:            radio task on core %d, %lu hold timeouts", dump_pipe_core,
+			(unsigned long)dump_pipe.hold_timeouts);
+	uint32_t n_cap = dump_capture.captured ? dump_capture.captured : 1;
+	uint32_t n_out = dump_pipe.frames ? dump_pipe.frames : 1;
+	dump_platform_debugln("  Stage avg/max us:    radio %lu/%lu, ring wait %lu/%lu, decode+out %lu/%lu",
+		(unsigned long)(dump_pipe.capture_sum / n_cap), (unsigned long)dump_pipe.capture_max,
+		(unsigned long)(dump_pipe.wait_sum / n_out), (unsigned long)dump_pipe.wait_max,
+		(unsigned long)(dump_pipe.output_sum / n_out), (unsigned long)dump_pipe.output_max);
+	dump_platform_debugln("  Ring depth at take:  %lu.%02lu avg",
+		(unsigned long)(dump_pipe.depth_sum / n_out), (unsigned long)((uint64_t)(dump_pipe.depth_sum % n_out) * 100 / n_out));
+	dump_platform_debugln("  Last RX settle:      %u us", NRF24L01_LastSettle());
+	dump_platform_debugln("  SPI clock:           %lu kHz", (unsigned long)(NRF24L01_SpiClock() / 1000));
+	dump_platform_debugln("");
+}
+
+#define CLI_BENCH_LOOPS 1000
+
+/* Register write/read latency through the active SPI/GPIO path */
+static void cli_bench(void)
+{
+	uint8_t ch = NRF24L01_ReadReg(NRF24L01_05_RF_CH);
+	uint64_t t0;
+	uint32_t t_wr, t_rd;
+
+	t0 = dump_platform_time_us();
+	for (uint16_t i = 0; i < CLI_BENCH_LOOPS; i++)
+		NRF24L01_WriteReg(NRF24L01_05_RF_CH, ch);
+	t_wr = (uint32_t)(dump_platform_time_us() - t0);
+
+	t0 = dump_platform_time_us();
+	for (uint16_t i = 0; i < CLI_BENCH_LOOPS; i++)
+		(void)NRF24L01_ReadReg(NRF24L01_05_RF_CH);
+	t_rd = (uint32_t)(dump_platform_time_us() - t0);
+
+	dump_platform_debugln("SPI backend: %s", dump_platform_spi_backend());
+	dump_platform_debugln("  WriteReg: %lu ns", (unsigned long)(t_wr * 1000UL / CLI_BENCH_LOOPS));
+	dump_platform_debugln("  ReadReg:  %lu ns", (unsigned long)(t_rd * 1000UL / CLI_BENCH_LOOPS));
+}
+
+#define CLI_DEC_PASSES_MAX 20
+
+static const char *const dec_rows[XN297_CORPUS_ROWS] = {
+	"std", "std shifted", "std scr", "std scr shifted",
+	"enh", "enh shifted", "enh scr", "enh scr shifted", "noise (FP)",
+};
+
+/* xn297_decode() on the labelled corpus (include/xn297_corpus.h), same rows as bench/bench_decode.cpp */
+static void cli_bench_decode(uint8_t passes)
+{
+	static xn297_corpus_result_t r;
+	uint32_t mhz = dump_platform_cpu_hz() / 1000000;
+
+	dump_platform_debugln("Decoding %u pass(es) of the frame corpus at %lu MHz...", passes, (unsigned long)mhz);
+	xn297_corpus_run(&r, passes, dump_platform_cycles, 1);
+	dump_platform_debugln("  %-16s %6s %6s %6s %8s %8s", "", "frames", "det%", "ok%", "cycles", "ns");
+	for (uint8_t i = 0; i < XN297_CORPUS_ROWS; i++) {
+		const xn297_corpus_score_t *s = &r.row[i];
+		uint32_t n = s->frames ? s->frames : 1;
+		uint32_t det = (uint32_t)((uint64_t)s->detected * 10000 / n), ok = (uint32_t)((uint64_t)s->correct * 10000 / n);
+		uint32_t cyc = (uint32_t)(s->ticks / n);
+		dump_platform_debugln("  %-16s %6lu %3lu.%02lu %3lu.%02lu %8lu %8lu", dec_rows[i], (unsigned long)s->frames,
+			(unsigned long)(det / 100), (unsigned long)(det % 100), (unsigned long)(ok / 100), (unsigned long)(ok % 100),
+			(unsigned long)cyc, (unsigned long)(mhz ? cyc * 1000UL / mhz : 0));
+	}
+	dump_platform_debugln("  clock read overhead %lu cycles (subtracted)", (unsigned long)r.clock_overhead);
+}
+
+#ifdef DUMP_PROF
+static const char *const prof_zones[DUMP_PROF_ZONES] = {
+	"loop", "radio", "spi", "settle", "drain", "decode", "tx poll", "cli",
+};
+
+/* Profiler zones since the last reset: time share of the elapsed time, avg/max cycles per call */
+static void cli_prof(void)
+{
+	uint32_t mhz = dump_platform_cpu_hz() / 1000000;
+	uint64_t elapsed = dump_platform_time_us() - dump_prof_since;
+
+	if (!mhz)
+		mhz = 1;
+	if (!elapsed)
+		elapsed = 1;
+	dump_platform_debugln("Profile over %lu ms at %lu MHz, %lu loops/s (inclusive, see dump_prof.h)",
+		(unsigned long)(elapsed / 1000), (unsigned long)mhz,
+		(unsigned long)((uint64_t)dump_prof[DUMP_PROF_LOOP].calls * 1000000 / elapsed));
+	dump_platform_debugln("  %-8s %9s %10s %7s %8s %9s", "zone", "calls", "us", "time%", "avg cyc", "max cyc");
+	for (uint8_t i = 0; i < DUMP_PROF_ZONES; i++) {
+		const dump_prof_zone_t *z = &dump_prof[i];
+		uint64_t us = z->cycles / mhz;
+		uint32_t share = (uint32_t)(us * 10000 / elapsed);
+		dump_platform_debugln("  %-8s %9lu %10lu %4lu.%02lu %8lu %9lu", prof_zones[i], (unsigned long)z->calls,
+			(unsigned long)us, (unsigned long)(share / 100), (unsigned long)(share % 100),
+			(unsigned long)(z->calls ? z->cycles / z->calls : 0), (unsigned long)z->max);
+	}
+	dump_prof_reset();
+}
+#endif
+
+#define CLI_STATS_PERIOD_MAX 3600
+#define CLI_STATS_FLUSH_LINES 16	/* per-channel lines between TX queue drains */
+
+static uint32_t stats_period_ms;	/* compact 'stats' line period, 0 = off */
+static uint64_t stats_last_us;
+
+/* Counters the compact line reports as deltas */
+typedef struct {
+	uint32_t loops, rx_dr, rpd_low, fifo_full, ring_full, ok, bad, queued, dropped, retunes, sweeps, decodes;
+	uint64_t decode_cycles;
+} cli_stats_snap_t;
+
+static cli_stats_snap_t stats_last;
+
+static void cli_stats_snap(cli_stats_snap_t *s)
+{
+	s->loops = dump_stats.loops;
+	s->rx_dr = dump_stats.rx_dr;
+	s->rpd_low = dump_stats.rpd_low;
+	s->fifo_full = dump_stats.fifo_full;
+	s->ring_full = dump_capture.overflow;
+	dump_stats_crc_totals(&s->ok, &s->bad);
+	s->queued = dump_txq.queued;
+	s->dropped = dump_txq.dropped;
+	s->retunes = dump_stats.retunes;
+	s->sweeps = dump_stats.sweeps;
+	s->decodes = dump_stats.decodes;
+	s->decode_cycles = dump_stats.decode_cycles;
+}
+
+static unsigned long per_s(uint32_t n, uint32_t ms)
+{
+	return (unsigned long)(ms ? (uint64_t)n * 1000 / ms : 0);
+}
+
+static void cli_print_stats(void)
+{
+	uint32_t ms = (uint32_t)((dump_platform_time_us() - dump_stats.since) / 1000);
+	uint32_t mhz = dump_platform_cpu_hz() / 1000000;
+	uint32_t ok, bad;
+	uint32_t n_dec = dump_stats.decodes ? dump_stats.decodes : 1;
+	uint32_t dec_avg = (uint32_t)(dump_stats.decode_cycles / n_dec);
+	uint32_t queued = dump_txq.queued - dump_stats.txq_queued0;
+	uint32_t sweeps100 = (uint32_t)(ms ? (uint64_t)dump_stats.sweeps * 100000 / ms : 0);
+
+	if (!mhz)
+		mhz = 1;
+	dump_stats_crc_totals(&ok, &bad);
+	/* Start from an empty TX queue: a running dump may have filled it */
+	dump_platform_tx_flush();
+	dump_platform_debugln("=== Capture Statistics ===");
+	dump_platform_debugln("  Elapsed:             %lu.%lu s", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000 / 100));
+	dump_platform_debugln("  Main loop:           %lu passes, %lu/s", (unsigned long)dump_stats.loops, per_s(dump_stats.loops, ms));
+	dump_platform_debugln("  RX_DR polls:         %lu (%lu/s), %lu with RPD low", (unsigned long)dump_stats.rx_dr,
+		per_s(dump_stats.rx_dr, ms), (unsigned long)dump_stats.rpd_low);
+	dump_platform_debugln("  RX FIFO:             %lu extra frames drained this run, full %lu times",
+		(unsigned long)rx_fifo_recovered, (unsigned long)dump_stats.fifo_full);
+	dump_platform_debugln("  Capture ring:        %lu frames dropped this run", (unsigned long)dump_capture.overflow);
+	dump_platform_debugln("  CRC:                 %lu ok, %lu bad, %lu ok only off the byte grid this run", (unsigned long)ok,
+		(unsigned long)bad, (unsigned long)XN297Dump_offset_recovered());
+	dump_platform_debugln("  Decode:              %lu frames, avg %lu / max %lu cycles (%lu / %lu ns)",
+		(unsigned long)dump_stats.decodes, (unsigned long)dec_avg, (unsigned long)dump_stats.decode_max,
+		(unsigned long)(dec_avg * 1000UL / mhz), (unsigned long)((uint64_t)dump_stats.decode_max * 1000 / mhz));
+	dump_platform_debugln("  Output:              %lu bytes queued (%lu B/s), %lu messages dropped (%lu bytes)",
+		(unsigned long)queued, per_s(queued, ms), (unsigned long)(dump_txq.dropped - dump_stats.txq_dropped0),
+		(unsigned long)(dump_txq.dropped_bytes - dump_stats.txq_dropped_bytes0));
+	dump_platform_debugln("  Channels:            %lu retunes (%lu/s), %lu sweeps (%lu.%02lu/s)",
+		(unsigned long)dump_stats.retunes, per_s(dump_stats.retunes, ms), (unsigned long)dump_stats.sweeps,
+		(unsigned long)(sweeps100 / 100), (unsigned long)(sweeps100 % 100));
+	if (ok + bad)
+		dump_platform_debugln("  CRC ok/bad per channel:");
+	/* Up to 255 lines, more than the TX queue holds: let it drain every few (the radio is held) */
+	uint8_t lines = 0;
+	for (uint8_t b = 0; b < DUMP_STATS_BITRATES; b++)
+		for (uint8_t c = 0; c < DUMP_STATS_CHANNELS; c++)
+			if (dump_stats.crc_ok[b][c] || dump_stats.crc_bad[b][c]) {
+				dump_platform_debugln("    %-4s C=%-3u %lu/%lu", mode_names[b], c,
+					(unsigned long)dump_stats.crc_ok[b][c], (unsigned long)dump_stats.crc_bad[b][c]);
+				if (++lines % CLI_STATS_FLUSH_LINES == 0)
+					dump_platform_tx_flush();
+			}
 	dump_platform_debugln("");
 }
 
+/* One line of deltas since the previous one */
+void cli_stats_poll(void)
+{
+	if (!stats_period_ms)
+		return;
+	uint64_t now = dump_platform_time_us();
+	uint32_t ms = (uint32_t)((now - stats_last_us) / 1000);
+	if (ms < stats_period_ms)
+		return;
+	cli_stats_snap_t s;
+	cli_stats_snap(&s);
+	uint32_t dec = s.decodes - stats_last.decodes;
+	dump_platform_debugln("stats: %lums loop %lu/s dr %lu rpd %lu crc %lu/%lu fifo3 %lu ring %lu queued %lu B/s drop %lu ch %lu/s sweep %lu dec %lu cyc",
+		(unsigned long)ms, per_s(s.loops - stats_last.loops, ms), (unsigned long)(s.rx_dr - stats_last.rx_dr),
+		(unsigned long)(s.rpd_low - stats_last.rpd_low), (unsigned long)(s.ok - stats_last.ok),
+		(unsigned long)(s.bad - stats_last.bad), (unsigned long)(s.fifo_full - stats_last.fifo_full),
+		(unsigned long)(s.ring_full >= stats_last.ring_full ? s.ring_full - stats_last.ring_full : s.ring_full), per_s(s.queued - stats_last.queued, ms),
+		(unsigned long)(s.dropped - stats_last.dropped), per_s(s.retunes - stats_last.retunes, ms),
+		(unsigned long)(s.sweeps - stats_last.sweeps),
+		(unsigned long)(dec ? (s.decode_cycles - stats_last.decode_cycles) / dec : 0));
+	stats_last = s;
+	stats_last_us = now;
+}
+
+#define CLI_TPUT_DEFAULT_S 5
+#define CLI_TPUT_DRAIN_US  2000000
+
+/* Keep the TX queue full of synthetic 32-byte records, report what left the port */
+static void cli_tput(uint8_t seconds)
+{
+	uint8_t data[DUMP_REC_MAX_DATA];
+	uint32_t records = 0;
+	uint32_t queued0;
+	uint64_t t0, now;
+
+	for (uint8_t i = 0; i < DUMP_REC_MAX_DATA; i++)
+		data[i] = 0x80 | i;
+	dump_platform_debugln("Streaming %us of binary records on %s...", seconds, dump_platform_port_name());
+	/* Start from an idle port: the line above is neither counted nor still in the driver */
+	dump_platform_tx_flush();
+	dump_output_reset();
+	queued0 = dump_txq.queued;
+	t0 = dump_platform_time_us();
+	while ((now = dump_platform_time_us()) - t0 < seconds * 1000000ULL) {
+		/* Only queue what fits: the test measures the port, not the drop path */
+		if (DUMP_TXQ_SIZE - dump_txq_used() >= 2 * (DUMP_REC_HDR_LEN + DUMP_REC_MAX_DATA + 2)) {
+			data[0] = (uint8_t)records;
+			dump_output_frame(now, (uint8_t)(records % 85), XN297DUMP_1M, DUMP_REC_F_CRC_OK | DUMP_REC_F_SCRAMBLE,
+				0, 5, data, DUMP_REC_MAX_DATA);
+			records++;
+		}
+		dump_platform_tx_poll();
+	}
+	while (dump_txq_used() && dump_platform_time_us() - now < CLI_TPUT_DRAIN_US)
+		dump_platform_tx_poll();
+	/* Up to a driver buffer (4 KB on USB) may still be on its way out: wait for it, inside the timing */
+	if (!dump_txq_used())
+		dump_platform_tx_flush();
+	uint32_t ms = (uint32_t)((dump_platform_time_us() - t0) / 1000);
+	uint32_t bytes = dump_txq.queued - queued0 - dump_txq_used();
+	dump_platform_debugln("");
+	dump_platform_debugln("Throughput on %s: %lu records, %lu bytes in %lu ms = %lu B/s",
+		dump_platform_port_name(), (unsigned long)records, (unsigned long)bytes, (unsigned long)ms,
+		(unsigned long)(ms ? (uint64_t)bytes * 1000 / ms : 0));
+}
+
 void cli_init(void)
 {
 	s_cmd_idx = 0;
@@ -99,6 +384,13 @@ void cli_init(void)
 	dump_platform_debug("> ");
 }
 
+/* p starts with the whole token w (followed by the end of the line or a space) */
+static bool cli_is_word(const char *p, const char *w)
+{
+	size_t n = strlen(w);
+	return strncmp(p, w, n) == 0 && (p[n] == '\0' || p[n] == ' ');
+}
+
 static void cli_parse_cmd(const char *cmd)
 {
 	char *p;
@@ -120,6 +412,95 @@ static void cli_parse_cmd(const char *cmd)
 	else if (strncmp(cmd, "detect", 6) == 0) {
 		cli_detect_nrf();
 	}
+	else if (strncmp(cmd, "out ", 4) == 0) {
+		p = (char *)cmd + 4;
+		while (*p == ' ') p++;
+		if (strncmp(p, "bin", 3) == 0) {
+			dump_output_mode = DUMP_OUTPUT_BINARY;
+			dump_platform_debugln("Output set to binary records");
+		} else if (strncmp(p, "text", 4) == 0) {
+			dump_output_mode = DUMP_OUTPUT_TEXT;
+			dump_platform_debugln("Output set to text");
+		} else {
+			dump_platform_debugln("Error: out must be text or bin");
+		}
+	}
+	else if (strncmp(cmd, "log ", 4) == 0) {
+		p = (char *)cmd + 4;
+		while (*p == ' ') p++;
+		if (strncmp(p, "tok", 3) == 0) {
+#ifdef DUMP_LOG_TOKENS
+			dump_platform_debugln("Log set to tokens");
+			dump_log_mode = DUMP_LOG_MODE_TOKENS;
+#else
+			dump_platform_debugln("Error: build with -DDUMP_LOG_TOKENS for tokenized log");
+#endif
+		} else if (strncmp(p, "text", 4) == 0) {
+			dump_log_mode = DUMP_LOG_MODE_TEXT;
+			dump_platform_debugln("Log set to text");
+		} else {
+			dump_platform_debugln("Error: log must be text or tok");
+		}
+	}
+	else if (strncmp(cmd, "port ", 5) == 0) {
+		p = (char *)cmd + 5;
+		while (*p == ' ') p++;
+		uint8_t port = cli_is_word(p, "usb") ? DUMP_PORT_USB : DUMP_PORT_UART;
+		if (!cli_is_word(p, "usb") && !cli_is_word(p, "uart"))
+			dump_platform_debugln("Error: port must be uart or usb");
+		else if (!dump_platform_set_port(port))
+			dump_platform_debugln("Error: %s not available in this build", p);
+		else
+			dump_platform_debugln("CLI and output now on %s", dump_platform_port_name());
+	}
+	else if (strncmp(cmd, "stats", 5) == 0) {
+		p = (char *)cmd + 5;
+		while (*p == ' ') p++;
+		if (strncmp(p, "reset", 5) == 0) {
+			dump_stats_reset();
+			cli_stats_snap(&stats_last);
+			stats_last_us = dump_stats.since;
+			dump_platform_debugln("Statistics reset");
+		} else if (*p >= '0' && *p <= '9') {
+			int val = atoi(p);
+			if (val > CLI_STATS_PERIOD_MAX)
+				val = CLI_STATS_PERIOD_MAX;
+			stats_period_ms = (uint32_t)val * 1000;
+			stats_last_us = dump_platform_time_us();
+			cli_stats_snap(&stats_last);
+			if (val)
+				dump_platform_debugln("Compact stats every %d s", val);
+			else
+				dump_platform_debugln("Compact stats off");
+		} else {
+			cli_print_stats();
+		}
+	}
+	else if (strncmp(cmd, "prof", 4) == 0) {
+#ifdef DUMP_PROF
+		cli_prof();
+#else
+		dump_platform_debugln("Error: build with -DDUMP_PROF for the profiler");
+#endif
+	}
+	else if (strncmp(cmd, "tput", 4) == 0) {
+		int val = atoi(cmd + 4);
+		if (cli_dump_running)
+			dump_platform_debugln("Stop the dump before running tput");
+		else
+			cli_tput(val > 0 && val <= 60 ? (uint8_t)val : CLI_TPUT_DEFAULT_S);
+	}
+	else if (strncmp(cmd, "bench", 5) == 0) {
+		p = (char *)cmd + 5;
+		while (*p == ' ') p++;
+		if (cli_dump_running)
+			dump_platform_debugln("Stop the dump before running bench");
+		else if (strncmp(p, "dec", 3) == 0) {
+			int val = atoi(p + 3);
+			cli_bench_decode(val > 0 && val <= CLI_DEC_PASSES_MAX ? (uint8_t)val : 1);
+		} else
+			cli_bench();
+	}
 	else if (strncmp(cmd, "mode ", 5) == 0 || strncmp(cmd, "sub ", 4) == 0) {
 		p = (char *)cmd + (cmd[0] == 'm' ? 5 : 4);
 		int val = atoi(p);
@@ -0,0 +1,82 @@
+/*
+ * Packet line formatter (see dump_fmt.h).
+ * Helpers clip at DUMP_FMT_LINE - 2 so fmt_emit always has room for CRLF.
+ */
+#include "../include/dump_fmt.h"
+#include "../include/dump_platform.h"
+
+#define FMT_ROOM(l, n) ((l)->len + (n) <= DUMP_FMT_LINE - 2)
+
+static const char hex_digit[16] = {
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+void fmt_str(dump_line_t *l, const char *s)
+{
+	while (*s && FMT_ROOM(l, 1))
+		l->buf[l->len++] = *s++;
+}
+
+void fmt_char(dump_line_t *l, char c)
+{
+	if (FMT_ROOM(l, 1))
+		l->buf[l->len++] = c;
+}
+
+void fmt_u(dump_line_t *l, uint32_t v, uint8_t width)
+{
+	char tmp[10];
+	uint8_t n = 0;
+	do {
+		tmp[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	while (width > n && FMT_ROOM(l, 1)) {
+		l->buf[l->len++] = ' ';
+		width--;
+	}
+	if (!FMT_ROOM(l, n))
+		return;
+	while (n)
+		l->buf[l->len++] = tmp[--n];
+}
+
+void fmt_i(dump_line_t *l, int v)
+{
+	if (v < 0) {
+		fmt_char(l, '-');
+		fmt_u(l, (uint32_t)(-(int32_t)v), 0);
+	} else
+		fmt_u(l, (uint32_t)v, 0);
+}
+
+void fmt_hex2(dump_line_t *l, uint8_t v)
+{
+	if (!FMT_ROOM(l, 2))
+		return;
+	l->buf[l->len++] = hex_digit[v >> 4];
+	l->buf[l->len++] = hex_digit[v & 0x0F];
+}
+
+void fmt_hex_bytes(dump_line_t *l, const uint8_t *p, uint8_t n)
+{
+	if (!FMT_ROOM(l, 3 * n))
+		n = (uint8_t)((DUMP_FMT_LINE - 2 - l->len) / 3);
+	char *o = &l->buf[l->len];
+	for (uint8_t i = 0; i < n; i++) {
+		*o++ = ' ';
+		*o++ = hex_digit[p[i] >> 4];
+		*o++ = hex_digit[p[i] & 0x0F];
+	}
+	l->len += 3 * n;
+}
+
+void fmt_emit(dump_line_t *l, uint8_t crlf)
+{
+	if (crlf) {
+		l->buf[l->len++] = '\r';
+		l->buf[l->len++] = '\n';
+	}
+	dump_platform_write((const uint8_t *)l->buf, l->len);
+	l->len = 0;
+}
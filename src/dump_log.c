@@ -0,0 +1,136 @@
+/*
+ * Tokenized logging (see dump_log.h). The format string is only walked
+ * to pick the argument types; nothing is formatted on the device.
+ */
+#include "../include/dump_log.h"
+#include "../include/dump_output.h"
+#include "../include/dump_platform.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_REC_MAX  DUMP_REC_MAX_LEN
+#define LOG_TEXT_MAX 192
+
+uint8_t dump_log_mode = DUMP_LOG_MODE_TEXT;
+
+static uint8_t put_varint(uint8_t *p, uint32_t v)
+{
+	uint8_t n = 0;
+	while (v >= 0x80) {
+		p[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (uint8_t)v;
+	return n;
+}
+
+static void log_text(uint8_t nl, const char *fmt, va_list ap)
+{
+	char buf[LOG_TEXT_MAX + 2];
+	int n = vsnprintf(buf, LOG_TEXT_MAX, fmt, ap);
+	if (n < 0)
+		return;
+	if (n > LOG_TEXT_MAX - 1)
+		n = LOG_TEXT_MAX - 1;
+	if (nl) {
+		buf[n++] = '\r';
+		buf[n++] = '\n';
+	}
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+void dump_log(uint32_t id, uint8_t nl, const char *fmt, ...)
+{
+	uint8_t rec[LOG_REC_MAX + 2];	/* + CRC */
+	uint8_t n = 0;
+	bool fits = true;
+	va_list ap, ap_text;
+
+	va_start(ap, fmt);
+	if (dump_log_mode != DUMP_LOG_MODE_TOKENS) {
+		log_text(nl, fmt, ap);
+		va_end(ap);
+		return;
+	}
+	va_copy(ap_text, ap);
+	rec[n++] = DUMP_REC_LOG;
+	rec[n++] = (uint8_t)id;
+	rec[n++] = (uint8_t)(id >> 8);
+	rec[n++] = (uint8_t)(id >> 16);
+	rec[n++] = (uint8_t)(id >> 24);
+	rec[n++] = nl;
+	for (const char *f = fmt; *f && fits; f++) {
+		if (*f != '%')
+			continue;
+		f++;
+		while (*f && strchr("-+ #0123456789.", *f))
+			f++;
+		uint8_t lng = 0;
+		while (*f == 'l' || *f == 'h' || *f == 'z') {
+			if (*f == 'l')
+				lng++;
+			f++;
+		}
+		if (*f && strchr("diuxXoc", *f) && n + 5 > LOG_REC_MAX) {
+			fits = false;	/* a varint is up to 5 bytes */
+			break;
+		}
+		switch (*f) {
+		case 'd':
+		case 'i': {
+			int32_t v;
+			if (lng > 1)
+				v = (int32_t)va_arg(ap, long long);
+			else if (lng)
+				v = (int32_t)va_arg(ap, long);
+			else
+				v = va_arg(ap, int);
+			n += put_varint(&rec[n], ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+			break;
+		}
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'c': {
+			uint32_t v;
+			if (lng > 1)
+				v = (uint32_t)va_arg(ap, unsigned long long);
+			else if (lng)
+				v = (uint32_t)va_arg(ap, unsigned long);
+			else
+				v = va_arg(ap, unsigned int);
+			n += put_varint(&rec[n], v);
+			break;
+		}
+		case 's': {
+			const char *s = va_arg(ap, const char *);
+			size_t len = strlen(s);
+			if (n + 1 + len > LOG_REC_MAX) {
+				fits = false;
+				break;
+			}
+			rec[n++] = (uint8_t)len;
+			memcpy(&rec[n], s, len);
+			n += (uint8_t)len;
+			break;
+		}
+		case '%':
+			break;
+		case '\0':
+			f--;
+			break;
+		default:
+			break;		/* no floats or pointers in log formats */
+		}
+	}
+	va_end(ap);
+	/* Arguments beyond one record: send this one as text rather than cut it short */
+	if (fits)
+		dump_output_record(rec, n);
+	else
+		log_text(nl, fmt, ap_text);
+	va_end(ap_text);
+}
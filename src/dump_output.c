@@ -0,0 +1,74 @@
+/*
+ * Binary packet records (see dump_output.h).
+ */
+#include "../include/dump_output.h"
+#include "../include/dump_platform.h"
+#include "../include/dump_types.h"
+#include "../include/dump_config.h"
+#include <string.h>
+
+uint8_t dump_output_mode = DUMP_OUTPUT_TEXT;
+static uint16_t output_seq;
+
+void dump_output_reset(void)
+{
+	output_seq = 0;
+}
+
+uint8_t cobs_encode(uint8_t *out, const uint8_t *in, uint8_t len)
+{
+	uint8_t code_pos = 0, code = 1, o = 1;
+	for (uint8_t i = 0; i < len; i++) {
+		if (in[i] == 0) {
+			out[code_pos] = code;
+			code_pos = o++;
+			code = 1;
+		} else {
+			out[o++] = in[i];
+			code++;
+		}
+	}
+	out[code_pos] = code;
+	return o;
+}
+
+void dump_output_frame(uint64_t time, uint8_t channel, uint8_t bitrate, uint8_t flags,
+	uint8_t pid, uint8_t addr_len, const uint8_t *data, uint8_t len)
+{
+	uint8_t rec[DUMP_REC_HDR_LEN + DUMP_REC_MAX_DATA + 2];
+	uint32_t t = (uint32_t)time;
+
+	if (len > DUMP_REC_MAX_DATA)
+		len = DUMP_REC_MAX_DATA;
+	rec[0] = DUMP_REC_FRAME;
+	rec[1] = (uint8_t)output_seq;
+	rec[2] = (uint8_t)(output_seq >> 8);
+	rec[3] = (uint8_t)t;
+	rec[4] = (uint8_t)(t >> 8);
+	rec[5] = (uint8_t)(t >> 16);
+	rec[6] = (uint8_t)(t >> 24);
+	rec[7] = sub_protocol;
+	rec[8] = channel;
+	rec[9] = bitrate;
+	rec[10] = flags;
+	rec[11] = pid;
+	rec[12] = addr_len;
+	rec[13] = len;
+	if (len)	/* a Bad CRC record carries no data (data may be NULL) */
+		memcpy(rec + DUMP_REC_HDR_LEN, data, len);
+	output_seq++;
+	dump_output_record(rec, DUMP_REC_HDR_LEN + len);
+}
+
+void dump_output_record(uint8_t *rec, uint8_t len)
+{
+	uint8_t buf[DUMP_REC_MAX_LEN + 2 + 3];
+	uint16_t c = crc16_ccitt_block(0xFFFF, rec, len);
+
+	rec[len++] = (uint8_t)c;
+	rec[len++] = (uint8_t)(c >> 8);
+	buf[0] = 0;
+	len = cobs_encode(buf + 1, rec, len);
+	buf[len + 1] = 0;
+	dump_platform_write(buf, len + 2);
+}
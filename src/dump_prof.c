@@ -0,0 +1,20 @@
+/*
+ * Cycle profiler zones (see dump_prof.h).
+ */
+#include "../include/dump_prof.h"
+#include <string.h>
+
+#ifdef DUMP_PROF
+dump_prof_zone_t dump_prof[DUMP_PROF_ZONES];
+uint64_t dump_prof_since;
+
+void dump_prof_reset(void)
+{
+	for (uint8_t i = 0; i < DUMP_PROF_ZONES; i++) {
+		uint32_t start = dump_prof[i].start;	/* zones open right now still close correctly */
+		memset(&dump_prof[i], 0, sizeof(dump_prof[i]));
+		dump_prof[i].start = start;
+	}
+	dump_prof_since = dump_platform_time_us();
+}
+#endif
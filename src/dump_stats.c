@@ -0,0 +1,29 @@
+/*
+ * Capture statistics (see dump_stats.h).
+ */
+#include "../include/dump_stats.h"
+#include "../include/dump_platform.h"
+#include "../include/dump_txq.h"
+#include <string.h>
+
+dump_stats_t dump_stats;
+
+void dump_stats_reset(void)
+{
+	memset(&dump_stats, 0, sizeof(dump_stats));
+	dump_stats.txq_queued0 = dump_txq.queued;
+	dump_stats.txq_dropped0 = dump_txq.dropped;
+	dump_stats.txq_dropped_bytes0 = dump_txq.dropped_bytes;
+	dump_stats.since = dump_platform_time_us();
+}
+
+void dump_stats_crc_totals(uint32_t *ok, uint32_t *bad)
+{
+	*ok = 0;
+	*bad = 0;
+	for (uint8_t b = 0; b < DUMP_STATS_BITRATES; b++)
+		for (uint8_t c = 0; c < DUMP_STATS_CHANNELS; c++) {
+			*ok += dump_stats.crc_ok[b][c];
+			*bad += dump_stats.crc_bad[b][c];
+		}
+}
@@ -0,0 +1,30 @@
+/*
+ * Serial transmit queue (see dump_txq.h).
+ */
+#include "../include/dump_txq.h"
+#include <string.h>
+
+dump_txq_t dump_txq;
+
+bool dump_txq_write(const void *data, uint16_t len)
+{
+	uint16_t head = dump_txq.head;
+	uint16_t used = (uint16_t)(head - __atomic_load_n(&dump_txq.tail, __ATOMIC_ACQUIRE));
+	if (len > DUMP_TXQ_SIZE - used) {
+		dump_txq.dropped++;
+		dump_txq.dropped_bytes += len;
+		return false;
+	}
+	uint16_t off = head & (DUMP_TXQ_SIZE - 1);
+	uint16_t first = DUMP_TXQ_SIZE - off;
+	if (first > len)
+		first = len;
+	memcpy(&dump_txq.buf[off], data, first);
+	memcpy(dump_txq.buf, (const uint8_t *)data + first, len - first);
+	__atomic_store_n(&dump_txq.head, (uint16_t)(head + len), __ATOMIC_RELEASE);
+	dump_txq.queued += len;
+	used += len;
+	if (used > dump_txq.peak)
+		dump_txq.peak = used;
+	return true;
+}
@@ -1,5 +1,8 @@
 /*
- * bit_reverse, crc16_update and globals for dump.
+ * bit_reverse, CRC16 and globals for dump.
+ * CRC16/CCITT (poly 0x1021) is table driven, one lookup per byte.
+ * XN297 descramble + bit reversal runs 4 bytes per step (RBIT on Cortex-M3,
+ * SWAR elsewhere), as do the bit-stream shifts used for off-phase frames.
  */
 #include "dump_config.h"
 #include "dump_types.h"
@@ -18,9 +21,8 @@ uint8_t  rf_ch_num;
 uint8_t  rx_tx_addr[5];
 uint16_t bind_counter;
 uint8_t  phase;
-uint16_t crc;
-uint16_t crc16_polynomial = 0x1021;
 uint8_t  prev_power = 0xFD;
+uint32_t rx_fifo_recovered;
 
 uint8_t bit_reverse(uint8_t b_in)
 {
@@ -32,13 +34,132 @@ uint8_t bit_reverse(uint8_t b_in)
 	return b_out;
 }
 
-void crc16_update(uint8_t a, uint8_t bits)
+/* Reverse the bits of each byte of w, keeping byte positions */
+static inline uint32_t bit_reverse_x4(uint32_t w)
 {
-	crc ^= (uint16_t)a << 8;
-	while (bits--) {
-		if (crc & 0x8000)
-			crc = (crc << 1) ^ crc16_polynomial;
-		else
-			crc = crc << 1;
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+	uint32_t r;
+	__asm__ ("rbit %0, %1" : "=r" (r) : "r" (w));	/* __RBIT */
+	return __builtin_bswap32(r);			/* __REV */
+#else
+	w = ((w >> 1) & 0x55555555U) | ((w & 0x55555555U) << 1);
+	w = ((w >> 2) & 0x33333333U) | ((w & 0x33333333U) << 2);
+	return ((w >> 4) & 0x0F0F0F0FU) | ((w & 0x0F0F0F0FU) << 4);
+#endif
+}
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t w)
+{
+	p[0] = w >> 24;
+	p[1] = w >> 16;
+	p[2] = w >> 8;
+	p[3] = w;
+}
+
+void xn297_descramble_reverse(uint8_t *out, const uint8_t *in, const uint8_t *scramble, uint8_t len)
+{
+	uint8_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		uint32_t w = load_be32(in + i);
+		if (scramble)
+			w ^= load_be32(scramble + i);
+		store_be32(out + i, bit_reverse_x4(w));
+	}
+	for (; i < len; i++)
+		out[i] = bit_reverse(in[i] ^ (scramble ? scramble[i] : 0));
+}
+
+void xn297_descramble_reverse_shift2(uint8_t *out, const uint8_t *in, const uint8_t *scramble, uint8_t len)
+{
+	uint8_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		uint32_t w = load_be32(in + i);
+		uint8_t next = in[i + 4];
+		if (scramble) {
+			w ^= load_be32(scramble + i);
+			next ^= scramble[i + 4];
+		}
+		store_be32(out + i, bit_reverse_x4((w << 2) | (next >> 6)));
 	}
+	for (; i < len; i++) {
+		uint8_t b0 = in[i], b1 = in[i + 1];
+		if (scramble) {
+			b0 ^= scramble[i];
+			b1 ^= scramble[i + 1];
+		}
+		out[i] = bit_reverse((b0 << 2) | (b1 >> 6));
+	}
+}
+
+/* Shift a bit stream towards the start by k (1..7) bits; the last k bits become 0 */
+void bitstream_shift_left(uint8_t *out, const uint8_t *in, uint8_t len, uint8_t k)
+{
+	uint8_t i = 0;
+	for (; i + 5 <= len; i += 4)
+		store_be32(out + i, (load_be32(in + i) << k) | (in[i + 4] >> (8 - k)));
+	for (; i < len; i++)
+		out[i] = (in[i] << k) | (i + 1 < len ? in[i + 1] >> (8 - k) : 0);
+}
+
+/* Shift a bit stream towards the end by k (1..7) bits, feeding in the low bits of fill */
+void bitstream_shift_right(uint8_t *out, const uint8_t *in, uint8_t len, uint8_t k, uint8_t fill)
+{
+	uint8_t i = 0, prev = fill;
+	for (; i + 4 <= len; i += 4) {
+		uint32_t w = load_be32(in + i);
+		store_be32(out + i, (w >> k) | ((uint32_t)prev << (32 - k)));
+		prev = (uint8_t)w;
+	}
+	for (; i < len; i++) {
+		out[i] = (in[i] >> k) | (uint8_t)(prev << (8 - k));
+		prev = in[i];
+	}
+}
+
+/* CRC16/CCITT, MSB first: crc16_ccitt_table[i] = i<<8 shifted through 8 steps of poly 0x1021 */
+const uint16_t crc16_ccitt_table[256] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+	0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+	0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+	0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+	0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+	0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+	0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+	0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+	0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+	0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+	0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+	0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+	0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+	0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+	0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+	0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+	0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+	0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+	0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+	0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+	0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+uint16_t crc16_ccitt_block(uint16_t c, const uint8_t *data, uint8_t len)
+{
+	while (len--)
+		c = crc16_ccitt_byte(c, *data++);
+	return c;
 }
@@ -1,6 +1,6 @@
 /*
  * RC model air sniffer - standalone XN297Dump (NRF24L01).
- * Build with platformio: env stm32f103 or esp32s3.
+ * Build with platformio: env stm32f103 or esp32s3 (native: host simulation).
  * 
  * CLI Commands:
  *   help              - show help
@@ -12,8 +12,10 @@
  *   stop              - stop dumping
  *   restart           - restart with current settings
  */
+#ifndef PIO_PLATFORM_NATIVE
 #include <Arduino.h>
 #include <SPI.h>
+#endif
 #include "../include/dump_config.h"
 #include "../include/dump_platform.h"
 #include "../include/dump_types.h"
@@ -2,43 +2,70 @@
  * NRF24L01 SPI driver (from Multiprotocol NRF24l01_SPI.ino).
  * Uses dump_platform for SPI and pins.
  */
-#include <Arduino.h>
+#include <stddef.h>
 #include "../include/iface_nrf24l01.h"
 #include "../include/dump_types.h"
 #include "../include/dump_platform.h"
+#include "../include/dump_prof.h"
 
 static uint8_t rf_setup;
 
-static void NRF_CSN_off(void) { dump_platform_nrf_csn_low(); }
-static void NRF_CSN_on(void)  { dump_platform_nrf_csn_high(); }
+/* Last value written to each single-byte register, for skipping redundant writes */
+#define NRF24L01_SHADOW_REGS 0x1E
+static uint8_t  nrf_shadow[NRF24L01_SHADOW_REGS];
+static uint32_t nrf_shadow_valid;
+static uint16_t nrf_last_settle_us;
+static uint32_t nrf_settle_start;	/* low 32 bits of dump_platform_time_us() */
+static bool     nrf_settling;
+static uint8_t  nrf_status;		/* STATUS, clocked out on the first byte of every command */
+
+/* Every transaction is bracketed by CSN: that is the profiler's spi zone */
+#define NRF_CSN_off do { DUMP_PROF_BEGIN(DUMP_PROF_SPI); dump_platform_nrf_csn_low(); } while (0)
+#define NRF_CSN_on  do { dump_platform_nrf_csn_high(); DUMP_PROF_END(DUMP_PROF_SPI); } while (0)
 
 #define NRF_CE_on  dump_platform_nrf_ce_high()
 #define NRF_CE_off dump_platform_nrf_ce_low()
 
 #define SPI_Write(b)  dump_platform_spi_write((b))
 #define SPI_Read()    dump_platform_spi_read()
+#define SPI_Cmd(b)    (nrf_status = dump_platform_spi_write((b)))
+#define SPI_Burst(tx, rx, len) dump_platform_spi_transfer((tx), (rx), (len))
 
 void NRF24L01_WriteReg(uint8_t reg, uint8_t data)
 {
+	reg &= REGISTER_MASK;
 	NRF_CSN_off;
-	SPI_Write(W_REGISTER | (REGISTER_MASK & reg));
+	SPI_Cmd(W_REGISTER | reg);
 	SPI_Write(data);
 	NRF_CSN_on;
+	/* STATUS bits are write-1-to-clear, never shadow them */
+	if (reg < NRF24L01_SHADOW_REGS && reg != NRF24L01_07_STATUS) {
+		nrf_shadow[reg] = data;
+		nrf_shadow_valid |= 1UL << reg;
+	}
+}
+
+uint8_t NRF24L01_WriteRegCached(uint8_t reg, uint8_t data)
+{
+	reg &= REGISTER_MASK;
+	if (reg < NRF24L01_SHADOW_REGS && (nrf_shadow_valid & (1UL << reg)) && nrf_shadow[reg] == data)
+		return 0;
+	NRF24L01_WriteReg(reg, data);
+	return 1;
 }
 
 void NRF24L01_WriteRegisterMulti(uint8_t reg, uint8_t *data, uint8_t length)
 {
 	NRF_CSN_off;
-	SPI_Write(W_REGISTER | (REGISTER_MASK & reg));
-	for (uint8_t i = 0; i < length; i++)
-		SPI_Write(data[i]);
+	SPI_Cmd(W_REGISTER | (REGISTER_MASK & reg));
+	SPI_Burst(data, NULL, length);
 	NRF_CSN_on;
 }
 
 uint8_t NRF24L01_ReadReg(uint8_t reg)
 {
 	NRF_CSN_off;
-	SPI_Write(R_REGISTER | (REGISTER_MASK & reg));
+	SPI_Cmd(R_REGISTER | (REGISTER_MASK & reg));
 	uint8_t data = SPI_Read();
 	NRF_CSN_on;
 	return data;
@@ -47,34 +74,66 @@ uint8_t NRF24L01_ReadReg(uint8_t reg)
 void NRF24L01_ReadRegisterMulti(uint8_t reg, uint8_t *data, uint8_t length)
 {
 	NRF_CSN_off;
-	SPI_Write(R_REGISTER | (REGISTER_MASK & reg));
-	for (uint8_t i = 0; i < length; i++)
-		data[i] = SPI_Read();
+	SPI_Cmd(R_REGISTER | (REGISTER_MASK & reg));
+	SPI_Burst(NULL, data, length);
 	NRF_CSN_on;
 }
 
 void NRF24L01_ReadPayload(uint8_t *data, uint8_t length)
 {
 	NRF_CSN_off;
-	SPI_Write(R_RX_PAYLOAD);
-	for (uint8_t i = 0; i < length; i++)
-		data[i] = SPI_Read();
+	SPI_Cmd(R_RX_PAYLOAD);
+	SPI_Burst(NULL, data, length);
 	NRF_CSN_on;
 }
 
 void NRF24L01_WritePayload(uint8_t *data, uint8_t length)
 {
 	NRF_CSN_off;
-	SPI_Write(W_TX_PAYLOAD);
-	for (uint8_t i = 0; i < length; i++)
-		SPI_Write(data[i]);
+	SPI_Cmd(W_TX_PAYLOAD);
+	SPI_Burst(data, NULL, length);
 	NRF_CSN_on;
 }
 
+/* Start a PLL/RX settle period; the caller polls NRF24L01_RxReady() instead of blocking */
+static void NRF24L01_Settle(uint16_t us)
+{
+	nrf_settle_start = (uint32_t)dump_platform_time_us();
+	nrf_last_settle_us = us;
+	nrf_settling = us != 0;
+	if (nrf_settling)
+		DUMP_PROF_BEGIN(DUMP_PROF_SETTLE);
+}
+
+bool NRF24L01_RxReady(void)
+{
+	if (!nrf_settling)
+		return true;
+	if ((uint32_t)dump_platform_time_us() - nrf_settle_start < nrf_last_settle_us)
+		return false;
+	nrf_settling = false;
+	DUMP_PROF_END(DUMP_PROF_SETTLE);
+	return true;
+}
+
+uint8_t NRF24L01_LastStatus(void)
+{
+	return nrf_status;
+}
+
+/* Single-byte NOP: cheapest way to poll STATUS (RX_DR, RX_P_NO) */
+uint8_t NRF24L01_Nop(void)
+{
+	NRF_CSN_off;
+	SPI_Cmd(NRF24L01_FF_NOP);
+	NRF_CSN_on;
+	return nrf_status;
+}
+
 static void NRF24L01_Strobe(uint8_t state)
 {
 	NRF_CSN_off;
-	SPI_Write(state);
+	SPI_Cmd(state);
 	NRF_CSN_on;
 }
 
@@ -104,23 +163,65 @@ void NRF24L01_SetTxRxMode(enum TXRX_State mode)
 	if (mode == TX_EN) {
 		NRF_CE_off;
 		NRF24L01_WriteReg(NRF24L01_00_CONFIG, (1 << NRF24L01_00_EN_CRC) | (1 << NRF24L01_00_CRCO) | (1 << NRF24L01_00_PWR_UP));
-		dump_platform_delay_us(130);
 		NRF_CE_on;
+		NRF24L01_Settle(NRF24L01_SETTLE_RX_US);
 	} else if (mode == RX_EN) {
 		NRF_CE_off;
 		NRF24L01_WriteReg(NRF24L01_00_CONFIG, (1 << NRF24L01_00_EN_CRC) | (1 << NRF24L01_00_CRCO) | (1 << NRF24L01_00_PWR_UP) | (1 << NRF24L01_00_PRIM_RX));
-		dump_platform_delay_us(130);
 		NRF_CE_on;
+		NRF24L01_Settle(NRF24L01_SETTLE_RX_US);
 	} else {
 		NRF24L01_WriteReg(NRF24L01_00_CONFIG, (1 << NRF24L01_00_EN_CRC));
 		NRF_CE_off;
 	}
 }
 
+/*
+ * Fast RX control. The chip stays powered up between packets and channel
+ * changes: a retune only drops CE (or PRIM_RX when CE is tied high on the
+ * board) around the RF_CH write, so only the 130us RX settle is paid, and
+ * registers whose shadowed value is unchanged are not rewritten.
+ * The settle is not waited for here, see NRF24L01_RxReady().
+ */
+uint16_t NRF24L01_RxRetune(uint8_t channel, uint8_t config)
+{
+	uint16_t settle = NRF24L01_SETTLE_RX_US;
+	bool powered = (nrf_shadow_valid & (1UL << NRF24L01_00_CONFIG)) && (nrf_shadow[NRF24L01_00_CONFIG] & _BV(NRF24L01_00_PWR_UP));
+
+	if (!powered)
+		settle = NRF24L01_SETTLE_PWR_UP_US;
+	if (dump_platform_nrf_has_ce())
+		NRF_CE_off;
+	else if (powered && (nrf_shadow[NRF24L01_00_CONFIG] & _BV(NRF24L01_00_PRIM_RX)))
+		NRF24L01_WriteReg(NRF24L01_00_CONFIG, nrf_shadow[NRF24L01_00_CONFIG] & ~_BV(NRF24L01_00_PRIM_RX));
+	NRF24L01_WriteRegCached(NRF24L01_05_RF_CH, channel);
+	NRF24L01_WriteReg(NRF24L01_07_STATUS, _BV(NRF24L01_07_RX_DR) | _BV(NRF24L01_07_TX_DS) | _BV(NRF24L01_07_MAX_RT));
+	NRF24L01_FlushRx();
+	NRF24L01_WriteRegCached(NRF24L01_00_CONFIG, config | _BV(NRF24L01_00_PWR_UP) | _BV(NRF24L01_00_PRIM_RX));
+	NRF_CE_on;
+	NRF24L01_Settle(settle);
+	return settle;
+}
+
+/* Back to listening on the same channel after a packet: no CE or CONFIG change, no settle */
+uint16_t NRF24L01_RxRearm(void)
+{
+	NRF24L01_WriteReg(NRF24L01_07_STATUS, _BV(NRF24L01_07_RX_DR) | _BV(NRF24L01_07_TX_DS) | _BV(NRF24L01_07_MAX_RT));
+	NRF24L01_FlushRx();
+	return 0;
+}
+
+uint16_t NRF24L01_LastSettle(void)
+{
+	return nrf_last_settle_us;
+}
+
 void NRF24L01_Initialize(void)
 {
 	rf_setup = 0x09;
 	prev_power = 0x00;
+	nrf_shadow_valid = 0;
+	nrf_settling = false;
 	NRF24L01_FlushTx();
 	NRF24L01_FlushRx();
 	NRF24L01_WriteReg(NRF24L01_01_EN_AA, 0x00);
@@ -147,9 +248,47 @@ uint8_t NRF24L01_Detect(void)
 			return 0;
 	}
 	
-	uint8_t status = NRF24L01_ReadReg(NRF24L01_07_STATUS);
+	/* STATUS came back on the read-back's command byte: no separate read */
+	uint8_t status = NRF24L01_LastStatus();
 	if (status == 0x00 || status == 0xFF)
 		return 0;
 	
 	return 1;
 }
+
+static uint32_t spi_hz;
+
+static uint8_t NRF24L01_SpiValidate(void)
+{
+	for (uint8_t i = 0; i < NRF24L01_SPI_TUNE_PASSES; i++)
+		if (!NRF24L01_Detect())
+			return 0;
+	return 1;
+}
+
+uint32_t NRF24L01_SpiAutotune(void)
+{
+	uint32_t good = 0, prev = 0;
+
+	for (uint32_t req = NRF24L01_SPI_HZ_MIN; ; req <<= 1) {
+		if (req > NRF24L01_SPI_HZ_MAX)
+			req = NRF24L01_SPI_HZ_MAX;
+		uint32_t hz = dump_platform_spi_set_clock(req);
+		if (hz != prev) {		/* platform may round two requests to the same divider */
+			if (!NRF24L01_SpiValidate())
+				break;
+			good = hz;
+			prev = hz;
+		}
+		if (req == NRF24L01_SPI_HZ_MAX)
+			break;
+	}
+	/* Fall back to the last rate that passed, or the slowest one if nothing did */
+	spi_hz = dump_platform_spi_set_clock(good ? good : NRF24L01_SPI_HZ_MIN);
+	return good;
+}
+
+uint32_t NRF24L01_SpiClock(void)
+{
+	return spi_hz;
+}
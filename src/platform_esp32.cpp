@@ -1,12 +1,23 @@
 /*
  * Platform implementation for ESP32-S3.
- * SPI (VSPI or default), NRF CSN/CE pins. Timer from micros().
+ * SPI (VSPI or default), NRF CSN/CE pins. Timer from esp_timer (64-bit systimer).
+ * Output is queued in dump_txq and topped up into the UART driver's
+ * interrupt-fed TX buffer as space frees, so a write never waits for
+ * the wire.
+ * With ARDUINO_USB_CDC_ON_BOOT (env esp32s3_usb) Serial is the native USB
+ * CDC port and Serial0 the UART; 'port' on the CLI switches between them.
+ * With DUMP_DUAL_CORE the radio stage runs in a task pinned to the other
+ * core, and both cores may print (Auto mode prints from the radio stage),
+ * so the TX queue is behind a mutex: a write can wait for the other
+ * core's queue/top-up, a few us of memcpy, but not for the UART.
  */
 #ifdef PIO_PLATFORM_ESP32
 
 #include "../include/dump_platform.h"
+#include "../include/dump_txq.h"
 #include <Arduino.h>
 #include <SPI.h>
+#include <esp_timer.h>
 
 extern "C" {
 
@@ -16,106 +27,316 @@ extern "C" {
 #ifndef NRF_CE_PIN
 #define NRF_CE_PIN   4
 #endif
+#ifndef NRF_IRQ_PIN
+#define NRF_IRQ_PIN  -1   /* not wired by default; e.g. -DNRF_IRQ_PIN=6 for the IRQ receive path */
+#endif
+
+#if ARDUINO_USB_CDC_ON_BOOT
+#define UART_PORT Serial0
+#define USB_PORT  Serial
+#else
+#define UART_PORT Serial
+#endif
+#ifndef DUMP_PORT_DEFAULT
+#define DUMP_PORT_DEFAULT DUMP_PORT_UART
+#endif
+
+#ifdef DUMP_DUAL_CORE
+#ifndef DUMP_CAPTURE_CORE
+#define DUMP_CAPTURE_CORE (ARDUINO_RUNNING_CORE ? 0 : 1)
+#endif
+#ifndef DUMP_CAPTURE_PRIO
+#define DUMP_CAPTURE_PRIO 3	/* above loopTask/idle, below the IDF system tasks */
+#endif
+static SemaphoreHandle_t s_tx_lock;
+#define TX_LOCK()   xSemaphoreTake(s_tx_lock, portMAX_DELAY)
+#define TX_UNLOCK() xSemaphoreGive(s_tx_lock)
+#else
+#define TX_LOCK()
+#define TX_UNLOCK()
+#endif
 
 static SPIClass *spi = nullptr;
+static Stream *s_port = &UART_PORT;
+static uint8_t s_port_id = DUMP_PORT_UART;
 
 void dump_platform_debug_init(void) {
-	Serial.begin(115200);
+#ifdef DUMP_DUAL_CORE
+	s_tx_lock = xSemaphoreCreateMutex();
+#endif
+	UART_PORT.setTxBufferSize(1024);
+	UART_PORT.begin(115200);
+#ifdef USB_PORT
+	USB_PORT.setTxBufferSize(4096);
+	USB_PORT.begin();
+#endif
+	dump_platform_set_port(DUMP_PORT_DEFAULT);
+}
+
+int dump_platform_set_port(uint8_t port) {
+	if (port == DUMP_PORT_UART) {
+		s_port = &UART_PORT;
+#ifdef USB_PORT
+	} else if (port == DUMP_PORT_USB) {
+		s_port = &USB_PORT;
+#endif
+	} else {
+		return 0;
+	}
+	s_port_id = port;
+	return 1;
+}
+
+const char *dump_platform_port_name(void) {
+	return s_port_id == DUMP_PORT_USB ? "usb" : "uart";
+}
+
+static void tx_drain(void) {
+	const uint8_t *p;
+	int room = s_port->availableForWrite();
+	while (room > 0) {
+		uint16_t n = dump_txq_linear(&p);
+		if (n == 0)
+			break;
+		if (n > room)
+			n = (uint16_t)room;
+		s_port->write(p, n);
+		dump_txq_consume(n);
+		room -= n;
+	}
 }
 
 void dump_platform_debug(const char *fmt, ...) {
 	char buf[192];
 	va_list ap;
 	va_start(ap, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, ap);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	Serial.print(buf);
+	if (n < 0)
+		return;
+	if (n > (int)sizeof(buf) - 1)
+		n = sizeof(buf) - 1;
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
 }
 
 void dump_platform_debugln(const char *fmt, ...) {
-	char buf[192];
+	char buf[192 + 2];
 	va_list ap;
 	va_start(ap, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, ap);
+	int n = vsnprintf(buf, 192, fmt, ap);
 	va_end(ap);
-	Serial.println(buf);
+	if (n < 0)
+		return;
+	if (n > 192 - 1)
+		n = 192 - 1;
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+void dump_platform_tx_poll(void) {
+	TX_LOCK();
+	tx_drain();
+	TX_UNLOCK();
+}
+
+void dump_platform_tx_flush(void) {
+	TX_LOCK();
+	while (dump_txq_used())
+		tx_drain();
+	s_port->flush();
+	TX_UNLOCK();
+}
+
+/* Never waits for the UART: queued for the background drain, or dropped and counted */
+void dump_platform_write(const uint8_t *buf, uint16_t len) {
+	TX_LOCK();
+	dump_txq_write(buf, len);
+	tx_drain();
+	TX_UNLOCK();
 }
 
 int dump_platform_serial_available(void) {
-	return Serial.available();
+	return s_port->available();
 }
 
 int dump_platform_serial_read(void) {
-	return Serial.read();
+	return s_port->read();
 }
 
 void dump_platform_serial_read_line(char *buf, int maxlen) {
 	int idx = 0;
 	while (idx < maxlen - 1) {
-		while (!Serial.available()) { yield(); }
-		int c = Serial.read();
+		while (!s_port->available()) { yield(); }
+		int c = s_port->read();
 		if (c == '\r' || c == '\n') {
 			if (idx > 0) break;
 			continue;
 		}
 		buf[idx++] = (char)c;
-		Serial.write((char)c);  /* echo */
+		dump_platform_write((const uint8_t *)&buf[idx - 1], 1);  /* echo */
 	}
 	buf[idx] = '\0';
-	Serial.println();
+	dump_platform_write((const uint8_t *)"\r\n", 2);
 }
 
-static uint16_t s_prev_cnt;
-
 void dump_platform_timer_init(void) {
-	s_prev_cnt = (uint16_t)(micros() & 0xFFFF);
-}
-
-uint32_t dump_platform_timer_get_us(void) {
-	return (uint32_t)micros() * 2U;
+	/* esp_timer is started by the IDF before setup() */
 }
 
-uint16_t dump_platform_timer_get_cnt(void) {
-	return (uint16_t)(micros() & 0xFFFF);
+uint64_t dump_platform_time_us(void) {
+	return (uint64_t)esp_timer_get_time();
 }
 
-uint16_t dump_platform_timer_get_timeH(void) {
-	return (uint16_t)((micros() >> 16) & 0xFFFF);
+uint32_t dump_platform_cycles(void) {
+	return ESP.getCycleCount();	/* CCOUNT of the calling core */
 }
 
-int dump_platform_timer_overflow(void) {
-	uint16_t c = (uint16_t)(micros() & 0xFFFF);
-	int ov = (c < s_prev_cnt) ? 1 : 0;
-	s_prev_cnt = c;
-	return ov;
+uint32_t dump_platform_cpu_hz(void) {
+	return getCpuFrequencyMhz() * 1000000UL;
 }
 
 void dump_platform_spi_init(void) {
 	spi = &SPI;
 	spi->begin();
+	dump_platform_spi_set_clock(1000000);	/* conservative until NRF24L01_SpiAutotune() */
 	pinMode(NRF_CSN_PIN, OUTPUT);
 	digitalWrite(NRF_CSN_PIN, HIGH);
 	pinMode(NRF_CE_PIN, OUTPUT);
 	digitalWrite(NRF_CE_PIN, HIGH);
 }
 
-void dump_platform_spi_write(uint8_t byte) {
-	spi->transfer(byte);
+uint8_t dump_platform_spi_write(uint8_t byte) {
+	return spi->transfer(byte);
 }
 
 uint8_t dump_platform_spi_read(void) {
 	return spi->transfer(0xFF);
 }
 
+/* The SPI clock is APB (80 MHz) / divider: report the rate the divider gives, not the request */
+uint32_t dump_platform_spi_set_clock(uint32_t hz) {
+	uint32_t div = spiFrequencyToClockDiv(hz);
+	spi->setClockDivider(div);
+	return spiClockDivToFrequency(div);
+}
+
+const char *dump_platform_spi_backend(void) {
+	return "SPIClass + digitalWrite";
+}
+
+/* One SPI master transaction through the 64-byte hardware buffer instead of per-byte calls */
+void dump_platform_spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+	spi->transferBytes(tx, rx, len);
+}
+
 void dump_platform_nrf_csn_high(void) { digitalWrite(NRF_CSN_PIN, HIGH); }
 void dump_platform_nrf_csn_low(void)  { digitalWrite(NRF_CSN_PIN, LOW); }
 void dump_platform_nrf_ce_high(void)  { digitalWrite(NRF_CE_PIN, HIGH); }
 void dump_platform_nrf_ce_low(void)   { digitalWrite(NRF_CE_PIN, LOW); }
+int  dump_platform_nrf_has_ce(void)   { return 1; }
+
+/* NRF IRQ falling edge: latch the timer so packets are stamped at arrival, not when polled */
+static volatile uint64_t s_irq_stamp;
+static volatile uint8_t  s_irq_flag;
+static portMUX_TYPE s_irq_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR nrf_irq_isr(void) {
+	portENTER_CRITICAL_ISR(&s_irq_mux);
+	s_irq_stamp = (uint64_t)esp_timer_get_time();
+	s_irq_flag = 1;
+	portEXIT_CRITICAL_ISR(&s_irq_mux);
+}
+
+int dump_platform_nrf_irq_init(void) {
+	if (NRF_IRQ_PIN < 0)
+		return 0;
+	pinMode(NRF_IRQ_PIN, INPUT_PULLUP);
+	attachInterrupt(digitalPinToInterrupt(NRF_IRQ_PIN), nrf_irq_isr, FALLING);
+	return 1;
+}
+
+int dump_platform_nrf_irq_asserted(void) {
+	return NRF_IRQ_PIN >= 0 && digitalRead(NRF_IRQ_PIN) == LOW;
+}
+
+int dump_platform_nrf_irq_take(uint64_t *stamp) {
+	portENTER_CRITICAL(&s_irq_mux);
+	int f = s_irq_flag;
+	s_irq_flag = 0;
+	*stamp = s_irq_stamp;
+	portEXIT_CRITICAL(&s_irq_mux);
+	return f;
+}
 
 void dump_platform_delay_us(unsigned int us) {
 	delayMicroseconds(us);
 }
 
+#ifdef DUMP_DUAL_CORE
+static int (*s_capture_step)(void);
+static TaskHandle_t s_capture_task;
+static TaskHandle_t s_main_task;	/* waits for the capture task's acknowledgements */
+
+static void capture_task(void *arg) {
+	(void)arg;
+	for (;;)
+		if (!s_capture_step())
+			vTaskDelay(1);
+}
+
+int dump_platform_capture_task_start(int (*step)(void)) {
+	s_capture_step = step;
+	s_main_task = xTaskGetCurrentTaskHandle();
+	/* The radio stage polls without blocking; that core's idle task never runs */
+#if DUMP_CAPTURE_CORE == 0
+	disableCore0WDT();
+#else
+	disableCore1WDT();
+#endif
+	if (xTaskCreatePinnedToCore(capture_task, "capture", 4096, NULL, DUMP_CAPTURE_PRIO, &s_capture_task,
+			DUMP_CAPTURE_CORE) != pdPASS)
+		return -1;
+	return DUMP_CAPTURE_CORE;
+}
+
+/* Parked on a task notification: the core idles instead of spinning while the CLI has the radio */
+void dump_platform_capture_task_park(void) {
+	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+void dump_platform_capture_task_wake(void) {
+	xTaskNotifyGive(s_capture_task);
+}
+
+void dump_platform_capture_task_ack(void) {
+	xTaskNotifyGive(s_main_task);
+}
+
+int dump_platform_capture_task_wait_ack(uint32_t timeout_ms) {
+	return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0;
+}
+#else
+int dump_platform_capture_task_start(int (*step)(void)) {
+	(void)step;
+	return -1;
+}
+
+void dump_platform_capture_task_park(void) {
+}
+
+void dump_platform_capture_task_wake(void) {
+}
+
+void dump_platform_capture_task_ack(void) {
+}
+
+int dump_platform_capture_task_wait_ack(uint32_t timeout_ms) {
+	(void)timeout_ms;
+	return 1;
+}
+#endif
+
 } /* extern "C" */
 
 #endif /* PIO_PLATFORM_ESP32 */
@@ -0,0 +1,801 @@
+/*
+ * Platform implementation for the host (env native): the firmware runs
+ * unmodified against a simulated NRF24L01 and a virtual clock.
+ *
+ * Clock: advances only by modelled costs. Every SPI byte takes
+ * 8 / spi_hz, delay_us() takes its argument, every main loop pass
+ * (one serial_available() call) takes -l ns and every time_us() read
+ * 100 ns, so busy-waits on the clock end. A run is deterministic for a
+ * given script and seed.
+ *
+ * Radio: register-level NRF24L01 model. It covers CONFIG (PWR_UP,
+ * PRIM_RX, EN_CRC/CRCO, IRQ masks), SETUP_AW, RF_CH, the RF_SETUP
+ * bitrate, STATUS (RX_DR, RX_P_NO, write-1-to-clear), RPD
+ * (NRF24L01_09_CD), RX_ADDR_P0/TX_ADDR, RX_PW_P0 and FIFO_STATUS. It
+ * also models the 3-level RX FIFO, FLUSH_RX and R_RX_PAYLOAD. Pipe 0
+ * only, fixed payload width, no TX.
+ * A frame is received when all of these hold:
+ *   - the chip has been in RX on its channel and bitrate since before
+ *     the frame started, after the 130 us settle (1.5 ms from power
+ *     down);
+ *   - the RX_ADDR_P0 bits appear in the frame at any bit offset;
+ *   - with EN_CRC, the CRC matches.
+ * The RX_PW_P0 bytes after the address are taken from the frame and
+ * then from seeded noise. RPD reads 1 once a frame was on air on the
+ * channel in the current RX window: it clears on entering or leaving
+ * RX, on a channel change and on FLUSH_RX (re-arm).
+ * -n adds noise frames at that average rate per second on whatever
+ * channel and bitrate the radio listens to: the RX address (the chip
+ * locking onto noise) followed by random bytes.
+ *
+ * Air script (-s), one event per line, times in us:
+ *   <t> air <ch> <250K|1M|2M> <hex>   frame on air from t; hex is
+ *                                     everything after the NRF preamble
+ *                                     byte, e.g. 710F55 + XN297 frame
+ *   <t> cli <command>                 typed on the CLI at t
+ *   <t> quit                          end of the run
+ * Output goes to stdout, drained at -b baud from the TX queue; -T logs
+ * when each line/record went out (tools/xn297_scenario.py). A summary
+ * goes to stderr at the end.
+ */
+#ifdef PIO_PLATFORM_NATIVE
+
+#include "../include/dump_platform.h"
+#include "../include/dump_txq.h"
+#include "../include/iface_nrf24l01.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SIM_AIR_MAX      64	/* bytes of one frame in the script */
+#define SIM_NOISE_LEN    96	/* frame + noise the receiver can clock out */
+#define SIM_CLI_MAX      64
+#define SIM_RX_SETTLE_NS 130000ULL
+#define SIM_PWR_UP_NS    1500000ULL
+#define SIM_TIME_READ_NS 100ULL
+#define SIM_NEVER        UINT64_MAX
+
+enum { SIM_EV_AIR, SIM_EV_CLI, SIM_EV_QUIT };
+
+typedef struct {
+	uint64_t due_ns;		/* air: end of frame; others: t */
+	uint64_t start_ns;
+	uint8_t  kind;
+	uint8_t  channel;
+	uint8_t  rf_dr;			/* RF_SETUP DR bits of the frame's bitrate */
+	uint8_t  len;
+	uint8_t  data[SIM_AIR_MAX];
+	char     text[SIM_CLI_MAX];
+} sim_event_t;
+
+static struct {
+	uint8_t  reg[0x20];
+	uint8_t  rx_addr_p0[5];
+	uint8_t  rx_addr_p1[5];
+	uint8_t  tx_addr[5];
+	uint8_t  fifo[3][32];
+	uint8_t  fifo_n;		/* frames queued, head is fifo[0] */
+	bool     ce, csn, listening;
+	uint64_t rx_from_ns;		/* settled in RX since, SIM_NEVER when not listening */
+	bool     irq_edge;
+	uint64_t irq_ns;
+	uint8_t  cmd;			/* SPI command of the current transaction */
+	uint8_t  idx;			/* data bytes clocked in this transaction */
+	bool     in_cmd;
+} nrf;
+
+static struct {
+	uint32_t air, noise, heard, matched, crc_fail, fifo_full, received, read;
+} sim_stats;
+
+static uint64_t     sim_ns;
+static uint64_t     sim_end_ns = SIM_NEVER;
+static uint64_t     loop_ns = 2000;
+static uint32_t     spi_hz = 1000000;
+static uint32_t     tx_baud = 115200;
+static uint64_t     tx_last_ns;
+static bool         irq_wired;
+static bool         pace_wall;	/* interactive: keep the virtual clock near wall time */
+static FILE        *timeline;	/* -T: "<stdout offset> <t_us>" at every line/record end */
+static uint64_t     out_bytes;
+static uint32_t     noise_seed = 1;
+static uint32_t     noise_rate;	/* -n: noise frames per second, 0 = none */
+static uint64_t     noise_next_ns = SIM_NEVER;
+static sim_event_t *events;
+static size_t       n_events, next_event;
+static char         in_buf[1024];
+static size_t       in_head, in_tail;
+
+static void sim_finish(void);
+static void sim_deliver(const sim_event_t *e);
+static void sim_noise(void);
+
+/* ---- Virtual clock ---- */
+
+static void sim_run_events(void)
+{
+	for (;;) {
+		uint64_t due = next_event < n_events ? events[next_event].due_ns : SIM_NEVER;
+		if (noise_next_ns <= sim_ns && noise_next_ns <= due) {
+			sim_noise();
+			continue;
+		}
+		if (due > sim_ns)
+			break;
+		const sim_event_t *e = &events[next_event++];
+		if (e->kind == SIM_EV_AIR) {
+			sim_stats.air++;
+			sim_deliver(e);
+		} else if (e->kind == SIM_EV_CLI) {
+			for (const char *c = e->text; *c && in_head - in_tail < sizeof(in_buf) - 1; c++)
+				in_buf[in_head++ % sizeof(in_buf)] = *c;
+			in_buf[in_head++ % sizeof(in_buf)] = '\r';
+		} else
+			sim_finish();
+	}
+	if (sim_ns >= sim_end_ns)
+		sim_finish();
+}
+
+static void sim_advance(uint64_t ns)
+{
+	sim_ns += ns;
+	sim_run_events();
+}
+
+/* ---- NRF24L01 model ---- */
+
+static uint8_t nrf_rf_dr(void)
+{
+	return nrf.reg[NRF24L01_06_RF_SETUP] & 0x28;	/* RF_DR_LOW | RF_DR_HIGH */
+}
+
+/* PWR_UP + PRIM_RX + CE: (re)entering RX starts a settle, leaving it ends reception */
+static void nrf_update_rx(bool retune, bool was_powered)
+{
+	uint8_t cfg = nrf.reg[NRF24L01_00_CONFIG];
+	bool rx = nrf.ce && (cfg & _BV(NRF24L01_00_PWR_UP)) && (cfg & _BV(NRF24L01_00_PRIM_RX));
+	if (rx != nrf.listening || retune)
+		nrf.reg[NRF24L01_09_CD] = 0;	/* new RX window */
+	if (rx && (!nrf.listening || retune))
+		nrf.rx_from_ns = sim_ns + (was_powered ? SIM_RX_SETTLE_NS : SIM_PWR_UP_NS);
+	else if (!rx)
+		nrf.rx_from_ns = SIM_NEVER;
+	nrf.listening = rx;
+}
+
+static uint8_t nrf_status(void)
+{
+	uint8_t s = nrf.reg[NRF24L01_07_STATUS] & 0x70;
+	s |= (nrf.fifo_n ? 0 : NRF24L01_RX_P_NO_EMPTY) << NRF24L01_07_RX_P_NO;
+	return s;
+}
+
+static uint8_t nrf_addr_width(void)
+{
+	uint8_t aw = nrf.reg[NRF24L01_03_SETUP_AW] & 0x03;
+	return aw ? aw + 2 : 0;
+}
+
+/* n (<= 56) bits of buf starting at bit pos, MSB first */
+static uint64_t bits_at(const uint8_t *buf, unsigned pos, uint8_t n)
+{
+	uint64_t v = 0;
+	for (uint8_t i = 0; i < n; i++, pos++)
+		v = (v << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+	return v;
+}
+
+static uint16_t crc16_step(uint16_t c, uint8_t b)
+{
+	c ^= (uint16_t)b << 8;
+	for (uint8_t i = 0; i < 8; i++)
+		c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+	return c;
+}
+
+static uint8_t crc8_step(uint8_t c, uint8_t b)
+{
+	c ^= b;
+	for (uint8_t i = 0; i < 8; i++)
+		c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1);
+	return c;
+}
+
+static uint8_t noise_byte(void)
+{
+	noise_seed = noise_seed * 1103515245u + 12345u;
+	return (uint8_t)(noise_seed >> 16);
+}
+
+static uint32_t rf_dr_bps(uint8_t rf_dr)
+{
+	return rf_dr == 0x20 ? 250000 : rf_dr == 0x08 ? 2000000 : 1000000;
+}
+
+/* -n: a burst the receiver takes for a frame, ending now on the channel it listens to */
+static void sim_noise(void)
+{
+	sim_event_t e;
+	uint8_t aw = nrf_addr_width();
+	memset(&e, 0, sizeof(e));
+	e.kind = SIM_EV_AIR;
+	e.channel = nrf.reg[NRF24L01_05_RF_CH];
+	e.rf_dr = nrf_rf_dr();
+	e.len = (uint8_t)(aw + 2 + noise_byte() % 31);
+	for (uint8_t i = 0; i < e.len; i++)
+		e.data[i] = i < aw ? nrf.rx_addr_p0[aw - 1 - i] : noise_byte();
+	e.due_ns = noise_next_ns;
+	e.start_ns = e.due_ns - (uint64_t)(e.len + 1) * 8 * 1000000000ULL / rf_dr_bps(e.rf_dr);
+	sim_stats.noise++;
+	sim_deliver(&e);
+	/* Uniform gap around 1 / rate keeps the rate and stays deterministic */
+	uint32_t r = (uint32_t)noise_byte() << 8 | noise_byte();
+	noise_next_ns += 1 + 2000000000ULL / noise_rate * r / 65536;
+}
+
+/* Frame ended on air: receive it if the radio was listening for it the whole time */
+static void sim_deliver(const sim_event_t *e)
+{
+	if (!nrf.listening || nrf.reg[NRF24L01_05_RF_CH] != e->channel)
+		return;
+	nrf.reg[NRF24L01_09_CD] = 1;
+	if (nrf.rx_from_ns > e->start_ns || nrf_rf_dr() != e->rf_dr)
+		return;
+	sim_stats.heard++;
+
+	uint8_t aw = nrf_addr_width();
+	uint8_t width = nrf.reg[NRF24L01_11_RX_PW_P0] & 0x3F;
+	if (aw == 0 || width == 0 || width > 32 || !(nrf.reg[NRF24L01_02_EN_RXADDR] & 0x01))
+		return;
+	uint8_t air[SIM_NOISE_LEN + 8];
+	memcpy(air, e->data, e->len);
+	for (unsigned i = e->len; i < sizeof(air); i++)
+		air[i] = noise_byte();
+
+	/* On air the address goes out last-written byte first */
+	uint64_t addr = 0;
+	for (uint8_t i = 0; i < aw; i++)
+		addr = (addr << 8) | nrf.rx_addr_p0[aw - 1 - i];
+	unsigned pos, last = e->len * 8u - aw * 8u;
+	for (pos = 0; pos <= last; pos++)
+		if (bits_at(air, pos, aw * 8) == addr)
+			break;
+	if (e->len < aw || pos > last)
+		return;
+	sim_stats.matched++;
+	pos += aw * 8;
+
+	uint8_t payload[32];
+	for (uint8_t i = 0; i < width; i++)
+		payload[i] = (uint8_t)bits_at(air, pos + i * 8u, 8);
+	uint8_t cfg = nrf.reg[NRF24L01_00_CONFIG];
+	if (cfg & _BV(NRF24L01_00_EN_CRC)) {
+		unsigned crc_pos = pos + width * 8u;
+		bool ok;
+		if (cfg & _BV(NRF24L01_00_CRCO)) {
+			uint16_t c = 0xFFFF;
+			for (uint8_t i = 0; i < aw; i++)
+				c = crc16_step(c, (uint8_t)(addr >> (8 * (aw - 1 - i))));
+			for (uint8_t i = 0; i < width; i++)
+				c = crc16_step(c, payload[i]);
+			ok = bits_at(air, crc_pos, 16) == c;
+		} else {
+			uint8_t c = 0xFF;
+			for (uint8_t i = 0; i < aw; i++)
+				c = crc8_step(c, (uint8_t)(addr >> (8 * (aw - 1 - i))));
+			for (uint8_t i = 0; i < width; i++)
+				c = crc8_step(c, payload[i]);
+			ok = bits_at(air, crc_pos, 8) == c;
+		}
+		if (!ok) {
+			sim_stats.crc_fail++;
+			return;
+		}
+	}
+	if (nrf.fifo_n == 3) {
+		sim_stats.fifo_full++;
+		return;
+	}
+	memcpy(nrf.fifo[nrf.fifo_n++], payload, 32);
+	sim_stats.received++;
+	nrf.reg[NRF24L01_07_STATUS] |= _BV(NRF24L01_07_RX_DR);
+	if (!(cfg & 0x40) && !nrf.irq_edge) {		/* MASK_RX_DR clear: IRQ pin falls */
+		nrf.irq_edge = true;
+		nrf.irq_ns = e->due_ns;
+	}
+}
+
+static uint8_t *nrf_addr_reg(uint8_t reg)
+{
+	switch (reg) {
+	case NRF24L01_0A_RX_ADDR_P0: return nrf.rx_addr_p0;
+	case NRF24L01_0B_RX_ADDR_P1: return nrf.rx_addr_p1;
+	case NRF24L01_10_TX_ADDR:    return nrf.tx_addr;
+	default:                     return NULL;
+	}
+}
+
+static uint8_t nrf_reg_read(uint8_t reg, uint8_t i)
+{
+	uint8_t *a = nrf_addr_reg(reg);
+	if (a)
+		return i < 5 ? a[i] : 0;
+	switch (reg) {
+	case NRF24L01_07_STATUS:
+		return nrf_status();
+	case NRF24L01_17_FIFO_STATUS:
+		return 0x10 | (nrf.fifo_n == 3 ? 0x02 : 0) | (nrf.fifo_n == 0 ? 0x01 : 0);
+	default:
+		return nrf.reg[reg];
+	}
+}
+
+static void nrf_reg_write(uint8_t reg, uint8_t i, uint8_t v)
+{
+	uint8_t *a = nrf_addr_reg(reg);
+	if (a) {
+		if (i < 5)
+			a[i] = v;
+		return;
+	}
+	if (i != 0)
+		return;
+	switch (reg) {
+	case NRF24L01_00_CONFIG: {
+		bool was_powered = nrf.reg[reg] & _BV(NRF24L01_00_PWR_UP);
+		nrf.reg[reg] = v & 0x7F;
+		nrf_update_rx(false, was_powered);
+		break;
+	}
+	case NRF24L01_05_RF_CH:
+		nrf.reg[reg] = v & 0x7F;
+		nrf_update_rx(true, true);
+		break;
+	case NRF24L01_07_STATUS:
+		nrf.reg[reg] &= ~(v & 0x70);
+		if (!(nrf.reg[reg] & 0x70))
+			nrf.irq_edge = false;
+		break;
+	case NRF24L01_08_OBSERVE_TX:
+	case NRF24L01_09_CD:
+	case NRF24L01_17_FIFO_STATUS:
+		break;				/* read only */
+	default:
+		if (reg < sizeof(nrf.reg))
+			nrf.reg[reg] = v;
+		break;
+	}
+}
+
+static void nrf_pop(void)
+{
+	if (nrf.fifo_n == 0)
+		return;
+	memmove(nrf.fifo[0], nrf.fifo[1], sizeof(nrf.fifo[0]) * 2);
+	nrf.fifo_n--;
+	sim_stats.read++;
+}
+
+static void nrf_reset(void)
+{
+	static const uint8_t reset[0x20] = {
+		0x08, 0x3F, 0x03, 0x03, 0x03, 0x02, 0x0F, 0x0E, 0x00, 0x00, 0, 0, 0xC3, 0xC4, 0xC5, 0xC6,
+		0, 0, 0, 0, 0, 0, 0, 0x11,
+	};
+	memcpy(nrf.reg, reset, sizeof(nrf.reg));
+	memset(nrf.rx_addr_p0, 0xE7, 5);
+	memset(nrf.rx_addr_p1, 0xC2, 5);
+	memset(nrf.tx_addr, 0xE7, 5);
+	nrf.csn = true;
+	nrf.rx_from_ns = SIM_NEVER;
+}
+
+/* ---- Script ---- */
+
+static int parse_rate(const char *s, uint8_t *dr)
+{
+	if (!strcmp(s, "250K")) *dr = 0x20;
+	else if (!strcmp(s, "1M")) *dr = 0x00;
+	else if (!strcmp(s, "2M")) *dr = 0x08;
+	else return 0;
+	return 1;
+}
+
+static int event_cmp(const void *a, const void *b)
+{
+	const sim_event_t *x = (const sim_event_t *)a, *y = (const sim_event_t *)b;
+	if (x->due_ns != y->due_ns)
+		return x->due_ns < y->due_ns ? -1 : 1;
+	return x < y ? -1 : 1;		/* qsort is not stable: keep script order */
+}
+
+static void load_script(const char *path)
+{
+	FILE *f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	char line[512];
+	unsigned lineno = 0;
+	size_t cap = 0;
+	if (f == NULL) {
+		perror(path);
+		exit(2);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		unsigned long long t;
+		char kind[8], a[16], b[8], hex[2 * SIM_AIR_MAX + 2];
+		int n;
+		lineno++;
+		line[strcspn(line, "\r\n#")] = 0;
+		if (sscanf(line, "%llu %7s %n", &t, kind, &n) < 2)
+			continue;
+		if (n_events == cap) {
+			cap = cap ? cap * 2 : 256;
+			events = (sim_event_t *)realloc(events, cap * sizeof(*events));
+		}
+		sim_event_t *e = &events[n_events];
+		memset(e, 0, sizeof(*e));
+		e->start_ns = e->due_ns = t * 1000;
+		if (!strcmp(kind, "air") && sscanf(line + n, "%15s %7s %129s", a, b, hex) == 3 &&
+				parse_rate(b, &e->rf_dr) && strlen(hex) % 2 == 0 && strlen(hex) <= 2 * SIM_AIR_MAX) {
+			e->kind = SIM_EV_AIR;
+			e->channel = (uint8_t)atoi(a);
+			e->len = (uint8_t)(strlen(hex) / 2);
+			for (uint8_t i = 0; i < e->len; i++)
+				sscanf(hex + 2 * i, "%2hhx", &e->data[i]);
+			e->due_ns += (uint64_t)(e->len + 1) * 8 * 1000000000ULL / rf_dr_bps(e->rf_dr);	/* + preamble */
+		} else if (!strcmp(kind, "cli")) {
+			e->kind = SIM_EV_CLI;
+			snprintf(e->text, sizeof(e->text), "%s", line + n);
+		} else if (!strcmp(kind, "quit")) {
+			e->kind = SIM_EV_QUIT;
+		} else {
+			fprintf(stderr, "%s:%u: bad event\n", path, lineno);
+			exit(2);
+		}
+		n_events++;
+	}
+	if (f != stdin)
+		fclose(f);
+	qsort(events, n_events, sizeof(*events), event_cmp);
+}
+
+static void tx_drain(bool all)
+{
+	const uint8_t *p;
+	uint64_t budget = UINT64_MAX;
+	if (tx_baud && !all) {
+		uint64_t ns_per_byte = 10000000000ULL / tx_baud;	/* 8N1 */
+		budget = (sim_ns - tx_last_ns) / ns_per_byte;
+		tx_last_ns += budget * ns_per_byte;
+	}
+	while (budget) {
+		uint16_t n = dump_txq_linear(&p);
+		if (n == 0) {
+			tx_last_ns = sim_ns;		/* line idle: no credit builds up */
+			break;
+		}
+		if (n > budget)
+			n = (uint16_t)budget;
+		fwrite(p, 1, n, stdout);
+		for (uint16_t i = 0; timeline && i < n; i++)
+			if (p[i] == '\n' || p[i] == 0)
+				fprintf(timeline, "%llu %llu\n", (unsigned long long)(out_bytes + i + 1),
+					(unsigned long long)(sim_ns / 1000));
+		out_bytes += n;
+		dump_txq_consume(n);
+		budget -= n;
+	}
+}
+
+static void sim_finish(void)
+{
+	tx_drain(true);
+	fflush(stdout);
+	if (timeline)
+		fclose(timeline);
+	fprintf(stderr, "sim: %llu.%06llu s, %lu air frames + %lu noise: %lu heard, %lu address match, %lu CRC fail, "
+		"%lu FIFO full, %lu received, %lu read\n",
+		(unsigned long long)(sim_ns / 1000000000ULL), (unsigned long long)(sim_ns / 1000 % 1000000),
+		(unsigned long)sim_stats.air, (unsigned long)sim_stats.noise, (unsigned long)sim_stats.heard, (unsigned long)sim_stats.matched,
+		(unsigned long)sim_stats.crc_fail, (unsigned long)sim_stats.fifo_full,
+		(unsigned long)sim_stats.received, (unsigned long)sim_stats.read);
+	fprintf(stderr, "sim: txq %lu bytes queued, %lu messages dropped, peak %u\n", (unsigned long)dump_txq.queued,
+		(unsigned long)dump_txq.dropped, dump_txq.peak);
+	exit(0);
+}
+
+extern "C" {
+
+void dump_platform_debug_init(void) {
+	fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+int dump_platform_set_port(uint8_t port) {
+	return port == DUMP_PORT_UART;
+}
+
+const char *dump_platform_port_name(void) {
+	return "stdio";
+}
+
+void dump_platform_tx_poll(void) {
+	tx_drain(false);
+}
+
+/* No driver buffer behind the queue: wait (in virtual time) for the line to drain it */
+void dump_platform_tx_flush(void) {
+	while (dump_txq_used()) {
+		sim_advance(tx_baud ? 10000000000ULL / tx_baud : 0);
+		tx_drain(false);
+	}
+}
+
+void dump_platform_debug(const char *fmt, ...) {
+	char buf[192];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if (n > (int)sizeof(buf) - 1)
+		n = sizeof(buf) - 1;
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+void dump_platform_debugln(const char *fmt, ...) {
+	char buf[192 + 2];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, 192, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if (n > 192 - 1)
+		n = 192 - 1;
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+void dump_platform_write(const uint8_t *buf, uint16_t len) {
+	dump_txq_write(buf, len);
+	tx_drain(false);
+}
+
+/* One main loop pass: costs loop_ns, picks up due CLI events and stdin */
+int dump_platform_serial_available(void) {
+	sim_advance(loop_ns);
+	if (in_head - in_tail < sizeof(in_buf)) {
+		char c;
+		if (read(STDIN_FILENO, &c, 1) == 1)
+			in_buf[in_head++ % sizeof(in_buf)] = c == '\n' ? '\r' : c;
+	}
+	if (pace_wall && (sim_ns & 0xFFFFF) < loop_ns) {	/* about once per virtual ms */
+		struct timespec ts = { 0, 1000000 };
+		nanosleep(&ts, NULL);
+	}
+	return (int)(in_head - in_tail);
+}
+
+int dump_platform_serial_read(void) {
+	if (in_head == in_tail)
+		return -1;
+	return (uint8_t)in_buf[in_tail++ % sizeof(in_buf)];
+}
+
+void dump_platform_serial_read_line(char *buf, int maxlen) {
+	int idx = 0;
+	while (idx < maxlen - 1) {
+		while (!dump_platform_serial_available())
+			;
+		int c = dump_platform_serial_read();
+		if (c == '\r' || c == '\n') {
+			if (idx > 0) break;
+			continue;
+		}
+		buf[idx++] = (char)c;
+		dump_platform_write((const uint8_t *)&buf[idx - 1], 1);  /* echo */
+	}
+	buf[idx] = '\0';
+}
+
+void dump_platform_timer_init(void) {
+}
+
+uint64_t dump_platform_time_us(void) {
+	sim_advance(SIM_TIME_READ_NS);
+	return sim_ns / 1000;
+}
+
+/* Host wall clock, not the virtual one: code cost is not part of the model */
+uint32_t dump_platform_cycles(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+uint32_t dump_platform_cpu_hz(void) {
+	return 1000000000UL;
+}
+
+void dump_platform_spi_init(void) {
+	nrf_reset();
+}
+
+uint8_t dump_platform_spi_write(uint8_t byte) {
+	sim_advance(8000000000ULL / spi_hz);
+	if (nrf.csn)
+		return 0xFF;			/* MISO released */
+	if (!nrf.in_cmd) {
+		nrf.in_cmd = true;
+		nrf.cmd = byte;
+		nrf.idx = 0;
+		uint8_t status = nrf_status();
+		if (byte == FLUSH_RX) {
+			nrf.fifo_n = 0;
+			nrf.reg[NRF24L01_09_CD] = 0;	/* re-armed: a new RX window */
+		}
+		return status;
+	}
+	uint8_t i = nrf.idx++;
+	uint8_t cmd = nrf.cmd;
+	if (cmd < W_REGISTER)
+		return nrf_reg_read(cmd & REGISTER_MASK, i);
+	if (cmd < NRF24L01_50_ACTIVATE) {
+		nrf_reg_write(cmd & REGISTER_MASK, i, byte);
+		return 0;
+	}
+	if (cmd == R_RX_PAYLOAD)
+		return nrf.fifo_n && i < 32 ? nrf.fifo[0][i] : 0;
+	if (cmd == NRF24L01_60_R_RX_PL_WID)
+		return nrf.reg[NRF24L01_11_RX_PW_P0];
+	return 0;				/* TX payload, ACTIVATE: not modelled */
+}
+
+uint8_t dump_platform_spi_read(void) {
+	return dump_platform_spi_write(0xFF);
+}
+
+void dump_platform_spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t b = dump_platform_spi_write(tx ? tx[i] : 0xFF);
+		if (rx)
+			rx[i] = b;
+	}
+}
+
+uint32_t dump_platform_spi_set_clock(uint32_t hz) {
+	spi_hz = hz ? hz : 1;
+	return spi_hz;
+}
+
+const char *dump_platform_spi_backend(void) {
+	return "sim";
+}
+
+void dump_platform_nrf_csn_high(void) {
+	if (!nrf.csn && nrf.in_cmd && nrf.cmd == R_RX_PAYLOAD && nrf.idx)
+		nrf_pop();
+	nrf.csn = true;
+	nrf.in_cmd = false;
+}
+
+void dump_platform_nrf_csn_low(void) {
+	nrf.csn = false;
+}
+
+void dump_platform_nrf_ce_high(void) {
+	nrf.ce = true;
+	nrf_update_rx(false, true);
+}
+
+void dump_platform_nrf_ce_low(void) {
+	nrf.ce = false;
+	nrf_update_rx(false, true);
+}
+
+int dump_platform_nrf_has_ce(void) {
+	return 1;
+}
+
+int dump_platform_nrf_irq_init(void) {
+	return irq_wired;
+}
+
+int dump_platform_nrf_irq_asserted(void) {
+	sim_run_events();
+	return irq_wired && (nrf.reg[NRF24L01_07_STATUS] & ~nrf.reg[NRF24L01_00_CONFIG] & 0x70);
+}
+
+int dump_platform_nrf_irq_take(uint64_t *stamp) {
+	if (!irq_wired || !nrf.irq_edge)
+		return 0;
+	*stamp = nrf.irq_ns / 1000;
+	nrf.irq_edge = false;
+	return 1;
+}
+
+void dump_platform_delay_us(unsigned int us) {
+	sim_advance((uint64_t)us * 1000);
+}
+
+int dump_platform_capture_task_start(int (*step)(void)) {
+	(void)step;
+	return -1;
+}
+
+void dump_platform_capture_task_park(void) {
+}
+
+void dump_platform_capture_task_wake(void) {
+}
+
+void dump_platform_capture_task_ack(void) {
+}
+
+int dump_platform_capture_task_wait_ack(uint32_t timeout_ms) {
+	(void)timeout_ms;
+	return 1;
+}
+
+} /* extern "C" */
+
+extern void setup(void);
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-s script] [-t end_us] [-b baud] [-l loop_ns] [-r seed] [-n rate] [-q] [-T timeline]\n"
+		"  -s  air/CLI event script ('-' = stdin); without it the CLI reads stdin in real time\n"
+		"  -t  stop at this virtual time (default: 100 ms after the last script event)\n"
+		"  -b  output line rate, 0 = unlimited (default 115200)\n"
+		"  -l  cost of one main loop pass in ns (default 2000)\n"
+		"  -r  noise seed\n"
+		"  -n  noise frames per second on the channel listened to (default 0)\n"
+		"  -q  NRF IRQ pin wired\n"
+		"  -T  write '<stdout offset> <t_us>' to this file at every line and record end\n", argv0);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *script = NULL;
+	long long end_us = -1;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:t:b:l:r:n:qT:h")) != -1) {
+		switch (opt) {
+		case 's': script = optarg; break;
+		case 't': end_us = atoll(optarg); break;
+		case 'b': tx_baud = (uint32_t)atol(optarg); break;
+		case 'l': loop_ns = (uint64_t)atoll(optarg); break;
+		case 'r': noise_seed = (uint32_t)atol(optarg); break;
+		case 'n': noise_rate = (uint32_t)atol(optarg); break;
+		case 'q': irq_wired = true; break;
+		case 'T':
+			if ((timeline = fopen(optarg, "w")) == NULL) {
+				perror(optarg);
+				exit(2);
+			}
+			break;
+		default: usage(argv[0]);
+		}
+	}
+	if (script) {
+		load_script(script);
+		if (n_events)
+			sim_end_ns = events[n_events - 1].due_ns + 100000000ULL;
+	} else
+		pace_wall = isatty(STDIN_FILENO);
+	if (end_us >= 0)
+		sim_end_ns = (uint64_t)end_us * 1000;
+	if (noise_rate)
+		noise_next_ns = 1000000000ULL / noise_rate;
+	setup();
+	return 0;
+}
+
+#endif /* PIO_PLATFORM_NATIVE */
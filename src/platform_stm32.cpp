@@ -1,11 +1,16 @@
 /*
  * Platform implementation for STM32F103 (e.g. 4-in-1 module).
- * SPI, NRF CSN on PB7. Timer uses micros() for portability.
+ * SPI, NRF CSN on PB7. Timestamps come from TIM2->TIM3->TIM4 chained at 1 MHz (48-bit).
+ * Burst SPI transfers use DMA1 channels 2/3 (SPI1 RX/TX).
+ * -DSTM32_FAST_IO drives CSN/CE through GPIO BSRR and polls SPI1 DR/SR directly
+ * instead of going through digitalWrite() and SPIClass::transfer().
  * Debug output uses hardware UART1 (Serial1); requires -DHAVE_HWSERIAL1 in platformio.ini.
+ * UART1 TX is fed from dump_txq by DMA1 channel 4; Serial1 only handles RX.
  */
 #ifdef PIO_PLATFORM_STM32
 
 #include "../include/dump_platform.h"
+#include "../include/dump_txq.h"
 #include <Arduino.h>
 #include <SPI.h>
 
@@ -17,29 +22,110 @@ extern "C" {
 #ifndef NRF_CE_PIN
 #define NRF_CE_PIN   -1   /* no CE control, tie high on board */
 #endif
+#ifndef NRF_IRQ_PIN
+#define NRF_IRQ_PIN  -1   /* not wired by default; e.g. -DNRF_IRQ_PIN=PB8 for the IRQ receive path */
+#endif
+/* -DNRF_IRQ_TIM2_CH=1..4 with NRF_IRQ_PIN on PA0..PA3: timestamp the IRQ edge by TIM2 input capture */
 
 static SPIClass *spi = nullptr;
 
+#ifdef STM32_FAST_IO
+/* Port and pin mask resolved once at init; BSRR low half sets, high half resets */
+static GPIO_TypeDef *s_csn_port;
+static uint32_t      s_csn_mask;
+static GPIO_TypeDef *s_ce_port;
+static uint32_t      s_ce_mask;
+#endif
+
+static volatile uint16_t s_tx_len;	/* bytes in flight on DMA1 channel 4, 0 = idle */
+
+/* Callers hold off the DMA ISR (or are it) */
+static void uart_tx_start(void) {
+	const uint8_t *p;
+	uint16_t n = dump_txq_linear(&p);
+	if (n == 0)
+		return;
+	s_tx_len = n;
+	DMA1_Channel4->CMAR = (uint32_t)p;
+	DMA1_Channel4->CNDTR = n;
+	DMA1_Channel4->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE | DMA_CCR_EN;
+}
+
+void DMA1_Channel4_IRQHandler(void) {
+	if (DMA1->ISR & DMA_ISR_TCIF4) {
+		DMA1->IFCR = DMA_IFCR_CGIF4;
+		DMA1_Channel4->CCR = 0;
+		dump_txq_consume(s_tx_len);
+		s_tx_len = 0;
+		uart_tx_start();
+	}
+}
+
 void dump_platform_debug_init(void) {
 	Serial1.begin(115200);
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+	DMA1_Channel4->CCR = 0;
+	DMA1_Channel4->CPAR = (uint32_t)&USART1->DR;
+	USART1->CR3 |= USART_CR3_DMAT;
+	NVIC_SetPriority(DMA1_Channel4_IRQn, 3);
+	NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+}
+
+int dump_platform_set_port(uint8_t port) {
+	return port == DUMP_PORT_UART;
+}
+
+const char *dump_platform_port_name(void) {
+	return "uart";
+}
+
+void dump_platform_tx_poll(void) {
+	noInterrupts();
+	if (s_tx_len == 0)
+		uart_tx_start();
+	interrupts();
+}
+
+/* DMA done only means the last byte reached USART1->DR: wait for the shift register too */
+void dump_platform_tx_flush(void) {
+	while (dump_txq_used())
+		dump_platform_tx_poll();
+	while (!(USART1->SR & USART_SR_TC))
+		;
 }
 
 void dump_platform_debug(const char *fmt, ...) {
 	char buf[128];
 	va_list ap;
 	va_start(ap, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, ap);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
 	va_end(ap);
-	Serial1.print(buf);
+	if (n < 0)
+		return;
+	if (n > (int)sizeof(buf) - 1)
+		n = sizeof(buf) - 1;
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
 }
 
 void dump_platform_debugln(const char *fmt, ...) {
-	char buf[128];
+	char buf[128 + 2];
 	va_list ap;
 	va_start(ap, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, ap);
+	int n = vsnprintf(buf, 128, fmt, ap);
 	va_end(ap);
-	Serial1.println(buf);
+	if (n < 0)
+		return;
+	if (n > 128 - 1)
+		n = 128 - 1;
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+	dump_platform_write((const uint8_t *)buf, (uint16_t)n);
+}
+
+/* Never blocks: queued for the background drain, or dropped and counted */
+void dump_platform_write(const uint8_t *buf, uint16_t len) {
+	dump_txq_write(buf, len);
+	dump_platform_tx_poll();
 }
 
 int dump_platform_serial_available(void) {
@@ -60,35 +146,68 @@ void dump_platform_serial_read_line(char *buf, int maxlen) {
 			continue;
 		}
 		buf[idx++] = (char)c;
-		Serial1.write((char)c);  /* echo */
+		dump_platform_write((const uint8_t *)&buf[idx - 1], 1);  /* echo */
 	}
 	buf[idx] = '\0';
-	Serial1.println();
+	dump_platform_write((const uint8_t *)"\r\n", 2);
 }
 
-static uint16_t s_prev_cnt;
-
+/*
+ * TIM2 counts 1 MHz and its update clocks TIM3, whose update clocks TIM4
+ * (ITR1 / ITR2, external clock mode 1): a 48-bit microsecond counter in
+ * hardware, 8.9 years before it wraps. TIM2-4 are unused by the core here
+ * (no tone()/Servo).
+ */
 void dump_platform_timer_init(void) {
-	s_prev_cnt = (uint16_t)(micros() & 0xFFFF);
-}
+	uint32_t tclk = HAL_RCC_GetPCLK1Freq();
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+		tclk *= 2;			/* APB1 timer clock doubler */
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN | RCC_APB1ENR_TIM4EN;
+	TIM2->CR1 = 0;
+	TIM3->CR1 = 0;
+	TIM4->CR1 = 0;
+
+	TIM2->PSC = tclk / 1000000U - 1;
+	TIM2->ARR = 0xFFFF;
+	TIM2->CR2 = TIM_CR2_MMS_1;		/* TRGO = update */
+	TIM2->EGR = TIM_EGR_UG;			/* load PSC before the chain is running */
+
+	TIM3->ARR = 0xFFFF;
+	TIM3->CR2 = TIM_CR2_MMS_1;
+	TIM3->SMCR = TIM_SMCR_TS_0 | TIM_SMCR_SMS;			/* ITR1 = TIM2 */
+	TIM4->ARR = 0xFFFF;
+	TIM4->SMCR = TIM_SMCR_TS_1 | TIM_SMCR_SMS;			/* ITR2 = TIM3 */
+
+	TIM2->CNT = 0;
+	TIM3->CNT = 0;
+	TIM4->CNT = 0;
+	TIM4->CR1 = TIM_CR1_CEN;
+	TIM3->CR1 = TIM_CR1_CEN;
+	TIM2->CR1 = TIM_CR1_CEN;
 
-uint32_t dump_platform_timer_get_us(void) {
-	return (uint32_t)micros() * 2U;
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
-uint16_t dump_platform_timer_get_cnt(void) {
-	return (uint16_t)(micros() & 0xFFFF);
+uint64_t dump_platform_time_us(void) {
+	uint16_t h, m, l;
+	do {
+		/* Re-read if a carry rippled up while sampling the lower half */
+		h = TIM4->CNT;
+		m = TIM3->CNT;
+		l = TIM2->CNT;
+	} while (m != TIM3->CNT || h != TIM4->CNT);
+	return ((uint64_t)h << 32) | ((uint32_t)m << 16) | l;
 }
 
-uint16_t dump_platform_timer_get_timeH(void) {
-	return (uint16_t)((micros() >> 16) & 0xFFFF);
+uint32_t dump_platform_cycles(void) {
+	return DWT->CYCCNT;
 }
 
-int dump_platform_timer_overflow(void) {
-	uint16_t c = (uint16_t)(micros() & 0xFFFF);
-	int ov = (c < s_prev_cnt) ? 1 : 0;
-	s_prev_cnt = c;
-	return ov;
+uint32_t dump_platform_cpu_hz(void) {
+	return SystemCoreClock;
 }
 
 void dump_platform_spi_init(void) {
@@ -96,32 +215,206 @@ void dump_platform_spi_init(void) {
 	spi->begin();
 	spi->setBitOrder(MSBFIRST);
 	spi->setDataMode(SPI_MODE0);
-	spi->setClockDivider(SPI_CLOCK_DIV8);  /* 9 MHz for 72MHz */
+	dump_platform_spi_set_clock(1000000);  /* conservative until NRF24L01_SpiAutotune() */
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
 	pinMode(NRF_CSN_PIN, OUTPUT);
 	digitalWrite(NRF_CSN_PIN, HIGH);
 	if (NRF_CE_PIN >= 0) {
 		pinMode(NRF_CE_PIN, OUTPUT);
 		digitalWrite(NRF_CE_PIN, HIGH);
 	}
+#ifdef STM32_FAST_IO
+	s_csn_port = digitalPinToPort(NRF_CSN_PIN);
+	s_csn_mask = digitalPinToBitMask(NRF_CSN_PIN);
+	if (NRF_CE_PIN >= 0) {
+		s_ce_port = digitalPinToPort(NRF_CE_PIN);
+		s_ce_mask = digitalPinToBitMask(NRF_CE_PIN);
+	}
+#endif
 }
 
-void dump_platform_spi_write(uint8_t byte) {
-	spi->transfer(byte);
+/* SPI1 runs from PCLK2 (= F_CPU on the F103); prescalers are 2..256 */
+static const uint32_t s_spi_divs[] = {
+	SPI_CLOCK_DIV2, SPI_CLOCK_DIV4, SPI_CLOCK_DIV8, SPI_CLOCK_DIV16,
+	SPI_CLOCK_DIV32, SPI_CLOCK_DIV64, SPI_CLOCK_DIV128, SPI_CLOCK_DIV256
+};
+
+uint32_t dump_platform_spi_set_clock(uint32_t hz) {
+	uint8_t i = 0;
+	while (i < 7 && (F_CPU >> (i + 1)) > hz)
+		i++;
+	spi->setClockDivider(s_spi_divs[i]);
+	SPI1->CR1 |= SPI_CR1_SPE;              /* keep SPI1 enabled for the DMA burst path */
+	return F_CPU >> (i + 1);
+}
+
+#ifdef STM32_FAST_IO
+uint8_t dump_platform_spi_write(uint8_t byte) {
+	while (!(SPI1->SR & SPI_SR_TXE)) { }
+	*(volatile uint8_t *)&SPI1->DR = byte;
+	while (!(SPI1->SR & SPI_SR_RXNE)) { }
+	return (uint8_t)SPI1->DR;
+}
+
+const char *dump_platform_spi_backend(void) {
+	return "SPI1 DR/SR + BSRR";
+}
+#else
+uint8_t dump_platform_spi_write(uint8_t byte) {
+	return spi->transfer(byte);
 }
 
+const char *dump_platform_spi_backend(void) {
+	return "SPIClass + digitalWrite";
+}
+#endif
+
 uint8_t dump_platform_spi_read(void) {
-	return spi->transfer(0xFF);
+	return dump_platform_spi_write(0xFF);
+}
+
+/*
+ * Burst transfer on SPI1 with DMA1 channel 2 (RX) and 3 (TX). Short bursts
+ * stay on programmed I/O, where the DMA setup would cost more than it saves.
+ */
+#define SPI_DMA_MIN_LEN 8
+
+static const uint8_t s_dma_fill = 0xFF;
+static uint8_t s_dma_sink;
+
+void dump_platform_spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+	if (len < SPI_DMA_MIN_LEN) {
+		for (uint16_t i = 0; i < len; i++) {
+			uint8_t b = dump_platform_spi_write(tx ? tx[i] : 0xFF);
+			if (rx)
+				rx[i] = b;
+		}
+		return;
+	}
+	while (SPI1->SR & SPI_SR_RXNE)
+		(void)SPI1->DR;
+	DMA1_Channel2->CCR = 0;
+	DMA1_Channel3->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+	DMA1_Channel2->CPAR = (uint32_t)&SPI1->DR;
+	DMA1_Channel2->CMAR = rx ? (uint32_t)rx : (uint32_t)&s_dma_sink;
+	DMA1_Channel2->CNDTR = len;
+	DMA1_Channel2->CCR = (rx ? DMA_CCR_MINC : 0) | DMA_CCR_PL_1;
+	DMA1_Channel3->CPAR = (uint32_t)&SPI1->DR;
+	DMA1_Channel3->CMAR = tx ? (uint32_t)tx : (uint32_t)&s_dma_fill;
+	DMA1_Channel3->CNDTR = len;
+	DMA1_Channel3->CCR = (tx ? DMA_CCR_MINC : 0) | DMA_CCR_DIR;
+	/* RM0008: enable RX DMA before TX so no received byte is missed */
+	SPI1->CR2 |= SPI_CR2_RXDMAEN;
+	DMA1_Channel2->CCR |= DMA_CCR_EN;
+	DMA1_Channel3->CCR |= DMA_CCR_EN;
+	SPI1->CR2 |= SPI_CR2_TXDMAEN;
+	while (!(DMA1->ISR & DMA_ISR_TCIF2)) { /* wait last byte in */ }
+	while (SPI1->SR & SPI_SR_BSY) { }
+	SPI1->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	DMA1_Channel2->CCR = 0;
+	DMA1_Channel3->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
 }
 
+#ifdef STM32_FAST_IO
+/* CSN must not rise while the last bit is still on the wire */
+void dump_platform_nrf_csn_high(void) { while (SPI1->SR & SPI_SR_BSY) { } s_csn_port->BSRR = s_csn_mask; }
+void dump_platform_nrf_csn_low(void)  { s_csn_port->BSRR = s_csn_mask << 16; }
+void dump_platform_nrf_ce_high(void) { if (NRF_CE_PIN >= 0) s_ce_port->BSRR = s_ce_mask; }
+void dump_platform_nrf_ce_low(void)  { if (NRF_CE_PIN >= 0) s_ce_port->BSRR = s_ce_mask << 16; }
+#else
 void dump_platform_nrf_csn_high(void) { digitalWrite(NRF_CSN_PIN, HIGH); }
 void dump_platform_nrf_csn_low(void)  { digitalWrite(NRF_CSN_PIN, LOW); }
 void dump_platform_nrf_ce_high(void) { if (NRF_CE_PIN >= 0) digitalWrite(NRF_CE_PIN, HIGH); }
 void dump_platform_nrf_ce_low(void)  { if (NRF_CE_PIN >= 0) digitalWrite(NRF_CE_PIN, LOW); }
+#endif
+int  dump_platform_nrf_has_ce(void)  { return NRF_CE_PIN >= 0; }
+
+#ifdef NRF_IRQ_TIM2_CH
+/* NRF IRQ falling edge captured by TIM2 in hardware: no ISR latency in the stamp */
+#define IRQ_CAP_CCR   (*(&TIM2->CCR1 + (NRF_IRQ_TIM2_CH - 1)))
+#define IRQ_CAP_FLAG  (TIM_SR_CC1IF << (NRF_IRQ_TIM2_CH - 1))
+
+int dump_platform_nrf_irq_init(void) {
+	if (NRF_IRQ_PIN < 0)
+		return 0;
+	pinMode(NRF_IRQ_PIN, INPUT_PULLUP);
+	/* CCxS = 01 (TIx input), falling edge; the capture holds TIM2, the low 16 bits of time_us */
+	if (NRF_IRQ_TIM2_CH <= 2)
+		TIM2->CCMR1 |= TIM_CCMR1_CC1S_0 << (8 * (NRF_IRQ_TIM2_CH - 1));
+	else
+		TIM2->CCMR2 |= TIM_CCMR2_CC3S_0 << (8 * (NRF_IRQ_TIM2_CH - 3));
+	TIM2->CCER |= (TIM_CCER_CC1E | TIM_CCER_CC1P) << (4 * (NRF_IRQ_TIM2_CH - 1));
+	(void)IRQ_CAP_CCR;			/* drop a stale capture */
+	return 1;
+}
+
+int dump_platform_nrf_irq_take(uint64_t *stamp) {
+	if (!(TIM2->SR & IRQ_CAP_FLAG))
+		return 0;
+	uint16_t cap = (uint16_t)IRQ_CAP_CCR;	/* read clears CCxIF */
+	uint64_t now = dump_platform_time_us();
+	/* Valid while the capture is less than one TIM2 period (65 ms) old */
+	*stamp = now - (uint16_t)((uint16_t)now - cap);
+	return 1;
+}
+#else
+/* NRF IRQ falling edge: latch the timer so packets are stamped at arrival, not when polled */
+static volatile uint64_t s_irq_stamp;
+static volatile uint8_t  s_irq_flag;
+
+static void nrf_irq_isr(void) {
+	s_irq_stamp = dump_platform_time_us();
+	s_irq_flag = 1;
+}
+
+int dump_platform_nrf_irq_init(void) {
+	if (NRF_IRQ_PIN < 0)
+		return 0;
+	pinMode(NRF_IRQ_PIN, INPUT_PULLUP);
+	attachInterrupt(digitalPinToInterrupt(NRF_IRQ_PIN), nrf_irq_isr, FALLING);
+	return 1;
+}
+
+int dump_platform_nrf_irq_take(uint64_t *stamp) {
+	noInterrupts();
+	int f = s_irq_flag;
+	s_irq_flag = 0;
+	*stamp = s_irq_stamp;
+	interrupts();
+	return f;
+}
+#endif
+
+int dump_platform_nrf_irq_asserted(void) {
+	return NRF_IRQ_PIN >= 0 && digitalRead(NRF_IRQ_PIN) == LOW;
+}
 
 void dump_platform_delay_us(unsigned int us) {
 	delayMicroseconds(us);
 }
 
+/* Single core: the main loop runs the radio stage */
+int dump_platform_capture_task_start(int (*step)(void)) {
+	(void)step;
+	return -1;
+}
+
+void dump_platform_capture_task_park(void) {
+}
+
+void dump_platform_capture_task_wake(void) {
+}
+
+void dump_platform_capture_task_ack(void) {
+}
+
+int dump_platform_capture_task_wait_ack(uint32_t timeout_ms) {
+	(void)timeout_ms;
+	return 1;
+}
+
 } /* extern "C" */
 
 #endif /* PIO_PLATFORM_STM32 */
@@ -0,0 +1,174 @@
+/*
+ * Labelled XN297 frame corpus (see xn297_corpus.h). Frames are built bit by
+ * bit the way an XN297 sends them, independently of the decoder code.
+ */
+#include "../include/xn297_corpus.h"
+#include "../include/xn297_tables.h"
+#include "../include/dump_types.h"
+#include <string.h>
+
+#define CORPUS_BUF_LEN 40		/* frame plus what the receiver clocks in after it */
+
+static uint8_t corpus_rand(uint32_t *seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (uint8_t)(*seed >> 24);
+}
+
+static void put_bits(uint8_t *b, uint16_t *pos, uint32_t v, uint8_t n)
+{
+	while (n--) {
+		uint8_t m = 0x80 >> (*pos & 7);
+		if ((v >> n) & 1)
+			b[*pos >> 3] |= m;
+		else
+			b[*pos >> 3] &= ~m;
+		(*pos)++;
+	}
+}
+
+uint8_t xn297_corpus_max_payload(uint8_t addr_len, bool enhanced, bool shifted)
+{
+	/* address + payload + CRC (+ 10-bit PCF) in 256 bits, 7 more when shifted */
+	uint16_t bits = 256 - (shifted ? 7 : 0) - 16 - (enhanced ? 10 : 0);
+	return (uint8_t)(bits / 8 - addr_len);
+}
+
+void xn297_corpus_make(xn297_corpus_frame_t *f, uint32_t *seed)
+{
+	uint8_t buf[CORPUS_BUF_LEN];
+	uint8_t al = f->addr_len, len = al + f->payload_len;
+	uint16_t pos = 0, crc = 0xb5d2;
+
+	for (uint8_t i = 0; i < sizeof(buf); i++)
+		buf[i] = corpus_rand(seed);
+	if (f->kind == XN297_CORPUS_NOISE)
+		memcpy(f->raw, buf, XN297_RAW_LEN);
+	for (uint8_t i = 0; i < al; i++)
+		f->addr[i] = corpus_rand(seed);
+	for (uint8_t i = 0; i < f->payload_len; i++)
+		f->payload[i] = corpus_rand(seed);
+	f->pid = f->enhanced ? corpus_rand(seed) & 3 : 0;
+	f->ack = f->enhanced && (corpus_rand(seed) & 1);
+	if (f->bit_offset < 0) {
+		/* Early frames only happen when their first bits read as the end of the 55 sync byte */
+		uint8_t k = (uint8_t)-f->bit_offset, top = (uint8_t)(0xFF << (8 - k));
+		uint8_t want = (uint8_t)(XN297_SYNC_TAIL << (8 - k)) ^ (f->scramble ? xn297_scramble[0] : 0);
+		f->addr[al - 1] = (f->addr[al - 1] & ~top) | (want & top);
+	}
+
+	for (uint8_t i = 0; i < al; i++)
+		put_bits(buf, &pos, f->addr[al - 1 - i], 8);
+	if (f->enhanced)
+		put_bits(buf, &pos, (f->payload_len << 3) | (f->pid << 1) | f->ack, 10);
+	for (uint8_t i = 0; i < f->payload_len; i++)
+		put_bits(buf, &pos, bit_reverse(f->payload[i]), 8);
+	if (f->scramble)
+		for (uint8_t i = 0; i < (pos + 7) / 8; i++)
+			buf[i] ^= xn297_scramble[i];
+	if (f->enhanced) {
+		for (uint8_t i = 0; i <= len; i++)
+			crc = crc16_ccitt_byte(crc, buf[i]);
+		crc = crc16_ccitt_2bits(crc, buf[len + 1]);
+		crc ^= (f->scramble ? xn297_crc_xorout_scrambled_enhanced : xn297_crc_xorout_enhanced)[len - 3];
+	} else {
+		for (uint8_t i = 0; i < len; i++)
+			crc = crc16_ccitt_byte(crc, buf[i]);
+		crc ^= (f->scramble ? xn297_crc_xorout_scrambled : xn297_crc_xorout)[len - 3];
+	}
+	put_bits(buf, &pos, crc, 16);
+
+	if (f->kind == XN297_CORPUS_NOISE) {
+		memcpy(f->prime, buf, XN297_RAW_LEN);
+		return;
+	}
+	/* Late: the receiver locked early, raw starts with the tail of the sync byte */
+	if (f->bit_offset > 0)
+		bitstream_shift_right(f->raw, buf, XN297_RAW_LEN, (uint8_t)f->bit_offset, XN297_SYNC_TAIL);
+	else if (f->bit_offset < 0)
+		bitstream_shift_left(f->raw, buf, XN297_RAW_LEN, (uint8_t)-f->bit_offset);
+	else
+		memcpy(f->raw, buf, XN297_RAW_LEN);
+	memcpy(f->prime, f->raw, XN297_RAW_LEN);
+}
+
+bool xn297_corpus_check(const xn297_corpus_frame_t *f, const xn297_frame_t *d)
+{
+	if (f->kind == XN297_CORPUS_NOISE)
+		return false;
+	if (d->addr_len != f->addr_len || d->payload_len != f->payload_len ||
+			d->scramble != f->scramble || d->enhanced != f->enhanced || d->bit_offset != f->bit_offset)
+		return false;
+	if (f->enhanced && (d->pid != f->pid || d->ack != f->ack))
+		return false;
+	return !memcmp(d->addr, f->addr, f->addr_len) && !memcmp(d->payload, f->payload, f->payload_len);
+}
+
+static void corpus_score(xn297_corpus_result_t *r, uint8_t row, xn297_decoder_t *d,
+	const xn297_corpus_frame_t *f, uint32_t (*clock)(void))
+{
+	xn297_corpus_score_t *s = &r->row[row];
+	xn297_frame_t fr;
+	/* Not scored: a shifted frame's transmitter sends until it is found (7 frames at most) */
+	if (f->kind == XN297_CORPUS_SHIFTED)
+		for (uint8_t i = 0; i < 7 && !xn297_decode(d, f->prime, &fr); i++)
+			;
+	else if (f->kind == XN297_CORPUS_NOISE)
+		xn297_decode(d, f->prime, &fr);
+	uint32_t t0 = clock();
+	bool ok = xn297_decode(d, f->raw, &fr);
+	uint32_t t = clock() - t0;
+	s->frames++;
+	s->ticks += t > r->clock_overhead ? t - r->clock_overhead : 0;
+	if (ok) {
+		s->detected++;
+		s->correct += xn297_corpus_check(f, &fr);
+	}
+}
+
+void xn297_corpus_run(xn297_corpus_result_t *r, uint16_t passes, uint32_t (*clock)(void), uint32_t seed)
+{
+	static xn297_corpus_frame_t f;	/* 80 bytes, kept off small task stacks */
+	xn297_decoder_t d;
+	uint8_t shift = 0;
+
+	memset(r, 0, sizeof(*r));
+	r->clock_overhead = UINT32_MAX;
+	for (uint8_t i = 0; i < 16; i++) {
+		uint32_t t0 = clock();
+		uint32_t t = clock() - t0;
+		if (t < r->clock_overhead)
+			r->clock_overhead = t;
+	}
+
+	while (passes--) {
+		for (uint8_t row = 0; row < XN297_CORPUS_ROW_NOISE; row++) {
+			bool shifted = row & 1;
+			f.kind = shifted ? XN297_CORPUS_SHIFTED : XN297_CORPUS_ALIGNED;
+			f.scramble = (row >> 1) & 1;
+			f.enhanced = (row >> 2) & 1;
+			for (f.addr_len = 3; f.addr_len <= 5; f.addr_len++) {
+				uint8_t max = xn297_corpus_max_payload(f.addr_len, f.enhanced, shifted);
+				xn297_decoder_init(&d, f.addr_len);
+				for (f.payload_len = 1; f.payload_len <= max; f.payload_len++) {
+					/* shifted: cycle through -7..-1, 1..7 */
+					shift = shift % 14 + 1;
+					f.bit_offset = shifted ? (int8_t)(shift <= 7 ? shift : 7 - shift) : 0;
+					xn297_corpus_make(&f, &seed);
+					corpus_score(r, row, &d, &f, clock);
+				}
+			}
+		}
+		f.kind = XN297_CORPUS_NOISE;
+		f.bit_offset = 0;
+		for (uint16_t i = 0; i < XN297_CORPUS_NOISE_PER_PASS; i++) {
+			f.addr_len = 3 + i % 3;
+			f.scramble = (i >> 2) & 1;
+			f.enhanced = (i >> 3) & 1;
+			f.payload_len = 1 + i % xn297_corpus_max_payload(f.addr_len, f.enhanced, false);
+			xn297_decoder_init(&d, f.addr_len);
+			xn297_corpus_make(&f, &seed);
+			corpus_score(r, XN297_CORPUS_ROW_NOISE, &d, &f, clock);
+		}
+	}
+}
@@ -0,0 +1,247 @@
+/*
+ * XN297 frame decoder (see xn297_decode.h) and the XN297 scramble/CRC
+ * tables shared with xn297_emu.cpp.
+ */
+#include "../include/xn297_decode.h"
+#include "../include/xn297_tables.h"
+#include "../include/dump_types.h"
+#include <stddef.h>
+#include <string.h>
+
+const uint8_t xn297_scramble[39] = {
+	0xE3, 0xB1, 0x4B, 0xEA, 0x85, 0xBC, 0xE5, 0x66,
+	0x0D, 0xAE, 0x8C, 0x88, 0x12, 0x69, 0xEE, 0x1F,
+	0xC7, 0x62, 0x97, 0xD5, 0x0B, 0x79, 0xCA, 0xCC,
+	0x1B, 0x5D, 0x19, 0x10, 0x24, 0xD3, 0xDC, 0x3F,
+	0x8E, 0xC5, 0x2F, 0xAA, 0x16, 0xF3, 0x95
+};
+
+const uint16_t xn297_crc_xorout_scrambled[35] = {
+	0x0000, 0x3448, 0x9BA7, 0x8BBB, 0x85E1, 0x3E8C,
+	0x451E, 0x18E6, 0x6B24, 0xE7AB, 0x3828, 0x814B,
+	0xD461, 0xF494, 0x2503, 0x691D, 0xFE8B, 0x9BA7,
+	0x8B17, 0x2920, 0x8B5F, 0x61B1, 0xD391, 0x7401,
+	0x2138, 0x129F, 0xB3A0, 0x2988, 0x23CA, 0xC0CB,
+	0x0C6C, 0xB329, 0xA0A1, 0x0A16, 0xA9D0
+};
+
+const uint16_t xn297_crc_xorout[35] = {
+	0x0000, 0x3D5F, 0xA6F1, 0x3A23, 0xAA16, 0x1CAF,
+	0x62B2, 0xE0EB, 0x0821, 0xBE07, 0x5F1A, 0xAF15,
+	0x4F0A, 0xAD24, 0x5E48, 0xED34, 0x068C, 0xF2C9,
+	0x1852, 0xDF36, 0x129D, 0xB17C, 0xD5F5, 0x70D7,
+	0xB798, 0x5133, 0x67DB, 0xD94E, 0x0A5B, 0xE445,
+	0xE6A5, 0x26E7, 0xBDAB, 0xC379, 0x8E20
+};
+
+const uint16_t xn297_crc_xorout_scrambled_enhanced[35] = {
+	0x0000, 0x7EBF, 0x3ECE, 0x07A4, 0xCA52, 0x343B,
+	0x53F8, 0x8CD0, 0x9EAC, 0xD0C0, 0x150D, 0x5186,
+	0xD251, 0xA46F, 0x8435, 0xFA2E, 0x7EBD, 0x3C7D,
+	0x94E0, 0x3D5F, 0xA685, 0x4E47, 0xF045, 0xB483,
+	0x7A1F, 0xDEA2, 0x9642, 0xBF4B, 0x032F, 0x01D2,
+	0xDC86, 0x92A5, 0x183A, 0xB760, 0xA953
+};
+
+const uint16_t xn297_crc_xorout_enhanced[35] = {
+	0x0000, 0x8BE6, 0xD8EC, 0xB87A, 0x42DC, 0xAA89,
+	0x83AF, 0x10E4, 0xE83E, 0x5C29, 0xAC76, 0x1C69,
+	0xA4B2, 0x5961, 0xB4D3, 0x2A50, 0xCB27, 0x5128,
+	0x7CDB, 0x7A14, 0xD5D2, 0x57D7, 0xE31D, 0xCE42,
+	0x648D, 0xBF2D, 0x653B, 0x190C, 0x9117, 0x9A97,
+	0xABFC, 0xE68E, 0x0DE7, 0x28A2, 0x1965
+};
+
+/* Standard frame: address back to MSB first, payload descrambled + bit reversed */
+static bool xn297_unpack_standard(xn297_decoder_t *d, const uint8_t *in, uint8_t al, uint8_t len,
+	bool scramble, xn297_frame_t *f)
+{
+	const uint8_t *s = scramble ? xn297_scramble : NULL;
+	for (uint8_t i = 0; i < al; i++)
+		d->out[al - 1 - i] = s ? in[i] ^ s[i] : in[i];
+	xn297_descramble_reverse(d->out + al, in + al, s ? s + al : NULL, len - al);
+	f->addr_len = al;
+	f->payload_len = len - al;
+	f->scramble = scramble;
+	f->enhanced = false;
+	f->pid = 0;
+	f->ack = false;
+	return true;
+}
+
+/* Checks on top of the CRC, by how the input was aligned */
+enum {
+	XN297_CHECK_NONE,	/* on the byte grid */
+	XN297_CHECK_PCF,	/* re-aligned: an enhanced frame's PCF length must fit a 3..5 byte address */
+	XN297_CHECK_LEARNED,	/* ... and only the learned format: a standard frame at its learned length */
+};
+
+static bool xn297_decode_aligned(xn297_decoder_t *d, const uint8_t *in, uint8_t check, xn297_frame_t *f)
+{
+	uint8_t al = d->addr_len;
+	uint16_t crc = 0xb5d2, crcxored;
+
+	for (uint8_t i = 0; i < al; i++)
+		crc = crc16_ccitt_byte(crc, in[i]);
+	for (uint8_t i = al; i < XN297_RAW_LEN - XN297_CRC_LEN; i++) {
+		crc = crc16_ccitt_byte(crc, in[i]);
+		if (check == XN297_CHECK_LEARNED && (d->learned_enhanced || i + 1 != d->learned_frame_len))
+			continue;
+		crcxored = crc ^ xn297_crc_xorout[i + 1 - 3];
+		if ((crcxored >> 8) == in[i + 1] && (crcxored & 0xff) == in[i + 2])
+			return xn297_unpack_standard(d, in, al, i + 1, false, f);
+		crcxored = crc ^ xn297_crc_xorout_scrambled[i + 1 - 3];
+		if ((crcxored >> 8) == in[i + 1] && (crcxored & 0xff) == in[i + 2])
+			return xn297_unpack_standard(d, in, al, i + 1, true, f);
+	}
+
+	if (check == XN297_CHECK_LEARNED && !d->learned_enhanced)
+		return false;
+
+	/* Enhanced: 9-bit PCF after the address, so the CRC sits 2 bits off the byte grid */
+	uint16_t crc_save = 0xb5d2;
+	uint8_t len = 0;
+	bool scramble = false;
+	for (uint8_t i = 0; i < XN297_RAW_LEN - XN297_CRC_LEN; i++) {
+		crc_save = crc16_ccitt_byte(crc_save, in[i]);
+		crc = crc16_ccitt_2bits(crc_save, in[i + 1]);
+		uint8_t tail = i + 3 < XN297_RAW_LEN ? in[i + 3] : 0;
+		crcxored = (in[i + 1] << 10) | (in[i + 2] << 2) | (tail >> 6);
+		if (i >= 3) {
+			if ((crc ^ xn297_crc_xorout_scrambled_enhanced[i - 3]) == crcxored) {
+				len = i;
+				scramble = true;
+				break;
+			}
+			if ((crc ^ xn297_crc_xorout_enhanced[i - 3]) == crcxored) {
+				len = i;
+				break;
+			}
+		}
+	}
+	if (len == 0)
+		return false;
+
+	const uint8_t *s = scramble ? xn297_scramble : NULL;
+#define XN297_UN(j) ((uint8_t)(in[j] ^ (s ? s[j] : 0)))
+	if ((XN297_UN(al) >> 1) != len - al) {
+		bool pcf_ok = false;
+		for (uint8_t i = 3; i <= 5; i++)
+			if ((XN297_UN(i) >> 1) == len - i) {
+				al = i;
+				pcf_ok = true;
+			}
+		if (check != XN297_CHECK_NONE && !pcf_ok)
+			return false;
+	}
+	if (len < al)
+		return false;		/* CRC hit inside the address: no payload to unpack */
+	f->pid = ((XN297_UN(al) & 0x01) << 1) | (XN297_UN(al + 1) >> 7);
+	f->ack = (XN297_UN(al + 1) >> 6) & 0x01;
+	for (uint8_t i = 0; i < al; i++)
+		d->out[al - 1 - i] = XN297_UN(i);
+#undef XN297_UN
+	xn297_descramble_reverse_shift2(d->out + al, in + al + 1, s ? s + al + 1 : NULL, len - al);
+	f->addr_len = al;
+	f->payload_len = len - al;
+	f->scramble = scramble;
+	f->enhanced = true;
+	return true;
+}
+
+void xn297_decoder_init(xn297_decoder_t *d, uint8_t addr_len)
+{
+	d->addr_len = addr_len;
+	d->offset_recovered = 0;
+	d->learned_len = 0;
+	d->search_early = 1;
+}
+
+/*
+ * Bit offset at which the learned address sits in raw, 0 if nowhere.
+ * Late by k: the address starts k bits into raw. Early by k: its first k
+ * bits went into the sync byte, so they must read as that byte's tail,
+ * and raw starts with the rest.
+ */
+static int8_t xn297_find_offset(const xn297_decoder_t *d, const uint8_t *raw)
+{
+	uint8_t n = d->learned_len * 8;		/* 24..40 bits */
+	uint64_t addr = 0, w = 0;
+
+	for (uint8_t i = 0; i < d->learned_len; i++)
+		addr = (addr << 8) | d->learned_addr[i];
+	for (uint8_t i = 0; i < 6; i++)
+		w = (w << 8) | raw[i];		/* first 48 bits */
+	for (uint8_t k = 1; k < 8; k++) {
+		if (((w >> (48 - k - n)) & ((1ULL << n) - 1)) == addr)
+			return (int8_t)k;
+		if ((addr >> (n - k)) == (XN297_SYNC_TAIL & ((1u << k) - 1)) &&
+				(w >> (48 - n + k)) == (addr & ((1ULL << (n - k)) - 1)))
+			return -(int8_t)k;
+	}
+	return 0;
+}
+
+static bool xn297_decode_at(xn297_decoder_t *d, const uint8_t *raw, int8_t offset, uint8_t check, xn297_frame_t *f)
+{
+	if (offset > 0)
+		bitstream_shift_left(d->shifted, raw, XN297_RAW_LEN, (uint8_t)offset);
+	else
+		bitstream_shift_right(d->shifted, raw, XN297_RAW_LEN, (uint8_t)-offset, XN297_SYNC_TAIL);
+	return xn297_decode_aligned(d, d->shifted, check, f);
+}
+
+/*
+ * First detection, for transmitters with no on-grid frame to learn from.
+ * Late by k: the receiver locked k bits early, so raw starts with the last
+ * k bits of the sync byte; only offsets where it does are decoded (one in
+ * 2^k on noise). Early frames leave nothing to check in raw, so one early
+ * offset is tried per frame, in turn: a transmitter that always lands k
+ * bits early is found within 7 of its frames, and after that through its
+ * address every time.
+ */
+static int8_t xn297_search(xn297_decoder_t *d, const uint8_t *raw, xn297_frame_t *f)
+{
+	for (uint8_t k = 1; k < 8; k++)
+		if ((raw[0] >> (8 - k)) == (XN297_SYNC_TAIL & ((1u << k) - 1)) &&
+				xn297_decode_at(d, raw, (int8_t)k, XN297_CHECK_PCF, f))
+			return (int8_t)k;
+	int8_t early = -(int8_t)d->search_early;
+	d->search_early = d->search_early % 7 + 1;
+	if (xn297_decode_at(d, raw, early, XN297_CHECK_PCF, f))
+		return early;
+	return 0;
+}
+
+/*
+ * The promiscuous address only locks the receiver onto a byte grid. Frames
+ * whose own preamble/address lands k bits later are shifted back; frames
+ * that started k bits earlier (the opposite preamble polarity, 0xAA vs 0x55)
+ * lost their first bits into the sync byte, so those are fed back in.
+ * Where the learned address shows up 1..7 bits off, only that offset is
+ * tried and the result must look like the learned frame. Otherwise the
+ * first-detection search runs, and a frame it finds is learned in turn.
+ * Noise costs about three decodes instead of 15.
+ */
+bool xn297_decode(xn297_decoder_t *d, const uint8_t *raw, xn297_frame_t *f)
+{
+	int8_t offset = 0;
+	bool ok = xn297_decode_aligned(d, raw, XN297_CHECK_NONE, f);
+	if (!ok && d->learned_len && (offset = xn297_find_offset(d, raw)) != 0)
+		ok = xn297_decode_at(d, raw, offset, XN297_CHECK_LEARNED, f) && f->addr_len == d->learned_len;
+	if (!ok)
+		ok = (offset = xn297_search(d, raw, f)) != 0;
+	if (!ok)
+		return false;
+	/* The learned address is kept as it sits on air, on the byte grid */
+	memcpy(d->learned_addr, offset ? d->shifted : raw, f->addr_len);
+	d->learned_len = f->addr_len;
+	d->learned_frame_len = f->addr_len + f->payload_len;
+	d->learned_enhanced = f->enhanced;
+	f->addr = d->out;
+	f->payload = d->out + f->addr_len;
+	f->bit_offset = offset;
+	if (offset)
+		d->offset_recovered++;
+	return true;
+}
@@ -6,117 +6,164 @@
 #include "../include/dump_platform.h"
 #include "../include/dump_types.h"
 #include "../include/dump_cli.h"
+#include "../include/dump_capture.h"
+#include "../include/dump_output.h"
+#include "../include/dump_fmt.h"
+#include "../include/dump_log.h"
+#include "../include/dump_prof.h"
+#include "../include/dump_stats.h"
 #include "../include/iface_nrf24l01.h"
 #include "../include/iface_xn297.h"
 #include "../include/xn297_tables.h"
+#include "../include/xn297_decode.h"
 #include <string.h>
 #include <stdlib.h>
 
 #define XN297DUMP_PERIOD_SCAN    50000
 #define XN297DUMP_MAX_RF_CHANNEL 84
 #define XN297DUMP_MAX_PACKET_LEN 32
-#define XN297DUMP_CRC_LENGTH     2
+#define XN297DUMP_HOLD_TIMEOUT_MS 100	/* a radio step takes microseconds */
+#define XN297DUMP_RX_CONFIG      (_BV(NRF24L01_00_CRCO) | _BV(NRF24L01_00_PWR_UP) | _BV(NRF24L01_00_PRIM_RX))	/* no CRC: raw capture */
 
 #define debug  dump_platform_debug
 #define debugln dump_platform_debugln
 
-static uint16_t timeH;
 static uint8_t  address_length;
 static uint8_t  bitrate;
 static uint8_t  old_option;
-static bool     scramble, enhanced, ack;
-static uint8_t  pid;
-static uint32_t time_stamp;
+static bool     enhanced;		/* Auto mode: detected frame format, for the later phases */
+static uint64_t time_stamp;
+static bool     irq_wired;		/* NRF IRQ pin connected: no STATUS polling */
+static uint8_t  decode_ch;		/* channel of the last frame taken off the capture ring */
+static xn297_decoder_t rx_decoder;	/* decode stage (capture ring consumer) */
+static xn297_decoder_t scan_decoder;	/* Auto mode, in the radio stage */
+static uint8_t  radio_hold;		/* main loop wants the radio: radio task parks between steps */
+static uint8_t  radio_held;		/* radio task acknowledges, not inside a step */
+static uint8_t  fifo_batch;		/* frames drained so far after the current RX_DR */
+static uint8_t  tuned_ch;		/* RF channel last tuned, for frames read straight from the FIFO */
 
 static uint8_t  *nbr_rf;
 static uint32_t *time_rf;
 static uint8_t  compare_channel;
 
-#define pgm_read_word(addr) (*(const uint16_t *)(addr))
-
 extern uint8_t bit_reverse(uint8_t);
-extern void crc16_update(uint8_t a, uint8_t bits);
 
-static bool XN297Dump_process_packet(void)
+static uint64_t XN297Dump_now(void)
 {
-	uint16_t crcxored;
-	uint8_t packet_sc[XN297DUMP_MAX_PACKET_LEN], packet_un[XN297DUMP_MAX_PACKET_LEN];
-	enhanced = false;
-	crc = 0xb5d2;
-
-	for (uint8_t i = 0; i < address_length; i++) {
-		crc16_update(packet[i], 8);
-		packet_un[address_length - 1 - i] = packet[i];
-		packet_sc[address_length - 1 - i] = packet[i] ^ xn297_scramble[i];
-	}
-	for (uint8_t i = address_length; i < XN297DUMP_MAX_PACKET_LEN - XN297DUMP_CRC_LENGTH; i++) {
-		crc16_update(packet[i], 8);
-		packet_sc[i] = bit_reverse(packet[i] ^ xn297_scramble[i]);
-		packet_un[i] = bit_reverse(packet[i]);
-		crcxored = crc ^ pgm_read_word(&xn297_crc_xorout[i + 1 - 3]);
-		if ((crcxored >> 8) == packet[i + 1] && (crcxored & 0xff) == packet[i + 2]) {
-			packet_length = i + 1;
-			memcpy(packet, packet_un, packet_length);
-			scramble = false;
-			return true;
-		}
-		crcxored = crc ^ pgm_read_word(&xn297_crc_xorout_scrambled[i + 1 - 3]);
-		if ((crcxored >> 8) == packet[i + 1] && (crcxored & 0xff) == packet[i + 2]) {
-			packet_length = i + 1;
-			memcpy(packet, packet_sc, packet_length);
-			scramble = true;
-			return true;
-		}
-	}
+	return dump_platform_time_us();
+}
 
-	uint16_t crc_save = 0xb5d2;
-	packet_length = 0;
-	for (uint8_t i = 0; i < XN297DUMP_MAX_PACKET_LEN - XN297DUMP_CRC_LENGTH; i++) {
-		packet_sc[i] = packet[i] ^ xn297_scramble[i];
-		crc = crc_save;
-		crc16_update(packet[i], 8);
-		crc_save = crc;
-		crc16_update(packet[i + 1] & 0xC0, 2);
-		crcxored = (packet[i + 1] << 10) | (packet[i + 2] << 2) | (packet[i + 3] >> 6);
-		if (i >= 3) {
-			if ((crc ^ pgm_read_word(&xn297_crc_xorout_scrambled_enhanced[i - 3])) == crcxored) {
-				packet_length = i;
-				scramble = true;
-				i++;
-				packet_sc[i] = packet[i] ^ xn297_scramble[i];
-				memcpy(packet_un, packet_sc, packet_length + 2);
-				break;
-			}
-			if ((crc ^ pgm_read_word(&xn297_crc_xorout_enhanced[i - 3])) == crcxored) {
-				packet_length = i;
-				scramble = false;
-				memcpy(packet_un, packet, packet_length + 2);
-				break;
-			}
-		}
+/* Arrival time of the frame being read: back-dated to the IRQ edge when the pin is wired */
+static uint64_t XN297Dump_frame_time(void)
+{
+	uint64_t now = XN297Dump_now();
+	uint64_t edge;
+	if (dump_platform_nrf_irq_take(&edge) && edge <= now)
+		return edge;
+	return now;
+}
+
+/* After every retune: counted for 'stats', and the channel CRC results are filed under */
+static void XN297Dump_retuned(uint8_t channel)
+{
+	tuned_ch = channel;
+	dump_stats.retunes++;
+}
+
+/* RX_DR pending: IRQ pin level when wired (no SPI traffic), STATUS poll otherwise */
+static bool XN297Dump_rx_ready(void)
+{
+	bool rx;
+	if (irq_wired)
+		rx = dump_platform_nrf_irq_asserted();
+	else
+		rx = NRF24L01_Nop() & _BV(NRF24L01_07_RX_DR);
+	if (rx) {
+		dump_stats.rx_dr++;
+		fifo_batch = 0;
 	}
-	if (packet_length != 0) {
-		enhanced = true;
-		if ((packet_un[address_length] >> 1) != packet_length - address_length) {
-			for (uint8_t i = 3; i <= 5; i++)
-				if ((packet_un[i] >> 1) == packet_length - i)
-					address_length = i;
-		}
-		pid = ((packet_un[address_length] & 0x01) << 1) | (packet_un[address_length + 1] >> 7);
-		ack = (packet_un[address_length + 1] >> 6) & 0x01;
-		for (uint8_t i = 0; i < address_length; i++)
-			packet[address_length - 1 - i] = packet_un[i];
-		for (uint8_t i = address_length; i < packet_length; i++)
-			packet[i] = bit_reverse((packet_un[i + 1] << 2) | (packet_un[i + 2] >> 6));
+	return rx;
+}
+
+/* RPD after RX_DR: the scans only take frames received above -64dBm */
+static bool XN297Dump_rpd(void)
+{
+	if (NRF24L01_ReadReg(NRF24L01_09_CD))
 		return true;
-	}
+	dump_stats.rpd_low++;
 	return false;
 }
 
-static void XN297Dump_overflow(void)
+/* True while frames the chip already received are still queued in its 3-level RX FIFO */
+static bool XN297Dump_rx_more(void)
+{
+	if (((NRF24L01_Nop() >> NRF24L01_07_RX_P_NO) & 0x07) == NRF24L01_RX_P_NO_EMPTY)
+		return false;
+	rx_fifo_recovered++;
+	if (++fifo_batch == 2)		/* third frame: every FIFO level was in use */
+		dump_stats.fifo_full++;
+	return true;
+}
+
+/* Read the next XN297 payload with the current length/mode, true if the CRC matched */
+static bool XN297Dump_read_xn297(void)
+{
+	bool ok;
+	if (enhanced)
+		ok = XN297_ReadEnhancedPayload(packet, packet_length) != 255;
+	else
+		ok = XN297_ReadPayload(packet, packet_length);
+	dump_stats_crc(tuned_ch, bitrate, ok);
+	return ok;
+}
+
+static bool XN297Dump_decode(xn297_decoder_t *d, const uint8_t *raw, xn297_frame_t *fr)
+{
+	DUMP_PROF_BEGIN(DUMP_PROF_DECODE);
+	uint32_t t0 = dump_platform_cycles();
+	bool ok = xn297_decode(d, raw, fr);
+	dump_stats_decode(dump_platform_cycles() - t0);
+	DUMP_PROF_END(DUMP_PROF_DECODE);
+	return ok;
+}
+
+/* Capture stage: stamp and copy one frame out of the RX FIFO, no decode or output */
+static void XN297Dump_capture(uint8_t channel, uint8_t len, bool xn297)
+{
+	dump_frame_t drop;
+	dump_frame_t *f = dump_capture_claim();
+	if (f == NULL)
+		f = &drop;		/* ring full: still pop the FIFO, frame is counted as overflow */
+	f->time = XN297Dump_frame_time();
+	f->channel = channel;
+	f->bitrate = bitrate;
+	f->len = len;
+	if (xn297)
+		f->flags = XN297_ReadPayload(f->data, len) ? DUMP_FRAME_CRC_OK : 0;
+	else {
+		NRF24L01_ReadPayload(f->data, len);
+		f->flags = 0;
+	}
+	if (f != &drop) {
+		f->queued = (uint32_t)XN297Dump_now();
+		dump_pipe_account(&dump_pipe.capture_sum, &dump_pipe.capture_max, f->queued - (uint32_t)f->time);
+		dump_capture_commit();
+	}
+}
+
+/* Channel change note, through the ring so it prints in order with the frames around it */
+static void XN297Dump_capture_channel(uint8_t channel)
 {
-	if (dump_platform_timer_overflow())
-		timeH++;
+	dump_frame_t *f = dump_capture_claim();
+	if (f == NULL)
+		return;
+	f->time = XN297Dump_now();
+	f->queued = (uint32_t)f->time;
+	f->channel = channel;
+	f->bitrate = bitrate;
+	f->len = 0;
+	f->flags = DUMP_FRAME_CHANNEL;
+	dump_capture_commit();
 }
 
 static void XN297Dump_RF_init(void)
@@ -158,8 +205,14 @@ void XN297Dump_init(void)
 	rf_ch_num = 0xFF;
 	old_option = option ^ 0x55;
 	phase = 0;
-	timeH = 0;
 	time_stamp = 0;
+	decode_ch = 0xFF;
+	rx_fifo_recovered = 0;
+	xn297_decoder_init(&rx_decoder, address_length);
+	xn297_decoder_init(&scan_decoder, address_length);
+	dump_capture_reset();
+	dump_output_reset();
+	irq_wired = dump_platform_nrf_irq_init();
 	nbr_rf = NULL;
 	time_rf = NULL;
 	
@@ -171,68 +224,90 @@ static void XN297Dump_mode_basic(void)
 	if (option == 0xFF && bind_counter > XN297DUMP_PERIOD_SCAN) {
 		hopping_frequency_no++;
 		bind_counter = 0;
-	}
+	} else if (option != 0xFF)
+		hopping_frequency_no = option;		/* fixed channel ('ch' can change it while running) */
 	if (hopping_frequency_no != rf_ch_num) {
-		if (hopping_frequency_no > XN297DUMP_MAX_RF_CHANNEL)
+		if (hopping_frequency_no > XN297DUMP_MAX_RF_CHANNEL) {
 			hopping_frequency_no = 0;
+			dump_stats.sweeps++;
+		}
 		rf_ch_num = hopping_frequency_no;
-		debugln("Channel=%d,0x%02X", hopping_frequency_no, hopping_frequency_no);
-		NRF24L01_WriteReg(NRF24L01_05_RF_CH, hopping_frequency_no);
-		NRF24L01_WriteReg(NRF24L01_07_STATUS, 0x70);
-		NRF24L01_SetTxRxMode(TXRX_OFF);
-		NRF24L01_SetTxRxMode(RX_EN);
-		NRF24L01_FlushRx();
-		NRF24L01_WriteReg(NRF24L01_00_CONFIG, (0 << NRF24L01_00_EN_CRC) | (1 << NRF24L01_00_CRCO) | (1 << NRF24L01_00_PWR_UP) | (1 << NRF24L01_00_PRIM_RX));
-		phase = 0;
+		XN297Dump_capture_channel(hopping_frequency_no);
+		NRF24L01_RxRetune(hopping_frequency_no, XN297DUMP_RX_CONFIG);
+		XN297Dump_retuned(hopping_frequency_no);
 	}
-	XN297Dump_overflow();
-
-	if (NRF24L01_ReadReg(NRF24L01_07_STATUS) & _BV(NRF24L01_07_RX_DR)) {
-		if (NRF24L01_ReadReg(NRF24L01_09_CD) || option != 0xFF) {
-			NRF24L01_ReadPayload(packet, XN297DUMP_MAX_PACKET_LEN);
-			XN297Dump_overflow();
-			uint16_t timeL = dump_platform_timer_get_cnt();
-			if (dump_platform_timer_overflow()) {
-				timeH++;
-				timeL = 0;
-			}
-			uint32_t time;
-			if ((phase & 0x01) == 0) {
-				phase = 1;
-				time = 0;
-			} else {
-				time = ((uint32_t)timeH << 16) + timeL - time_stamp;
-			}
-			if (XN297Dump_process_packet()) {
-				debug("RX: %5luus C=%d ", (unsigned long)(time >> 1), hopping_frequency_no);
-				time_stamp = ((uint32_t)timeH << 16) + timeL;
-				if (enhanced) {
-					debug("Enhanced ");
-					debug("pid=%d ", pid);
-					if (ack) debug("ack ");
-				}
-				debug("S=%c A=", scramble ? 'Y' : 'N');
-				for (uint8_t i = 0; i < address_length; i++)
-					debug(" %02X", packet[i]);
-				debug(" P(%d)=", packet_length - address_length);
-				for (uint8_t i = address_length; i < packet_length; i++)
-					debug(" %02X", packet[i]);
-				debugln("");
-			} else {
-				debugln("RX: %5luus C=%d Bad CRC", (unsigned long)(time >> 1), hopping_frequency_no);
-			}
-			XN297Dump_overflow();
-			NRF24L01_WriteReg(NRF24L01_07_STATUS, 0x70);
-			NRF24L01_SetTxRxMode(TXRX_OFF);
-			NRF24L01_SetTxRxMode(RX_EN);
-			NRF24L01_FlushRx();
-			NRF24L01_WriteReg(NRF24L01_00_CONFIG, (0 << NRF24L01_00_EN_CRC) | (1 << NRF24L01_00_CRCO) | (1 << NRF24L01_00_PWR_UP) | (1 << NRF24L01_00_PRIM_RX));
-			XN297Dump_overflow();
+
+	if (XN297Dump_rx_ready()) {
+		if (XN297Dump_rpd() || option != 0xFF) {	/* a fixed channel keeps frames below -64dBm too */
+			do
+				XN297Dump_capture(hopping_frequency_no, XN297DUMP_MAX_PACKET_LEN, false);
+			while (XN297Dump_rx_more());
+			NRF24L01_RxRearm();
 		}
 	}
 	bind_counter++;
 }
 
+/* "[Enhanced pid=N [ack ]]S=Y A= .. P(n)= .." of a decoded frame */
+static void XN297Dump_fmt_decoded(dump_line_t *l, const xn297_frame_t *fr)
+{
+	if (fr->enhanced) {
+		fmt_str(l, "Enhanced pid=");
+		fmt_u(l, fr->pid, 0);
+		fmt_str(l, fr->ack ? " ack " : " ");
+	}
+	fmt_str(l, "S=");
+	fmt_char(l, fr->scramble ? 'Y' : 'N');
+	fmt_str(l, " A=");
+	fmt_hex_bytes(l, fr->addr, fr->addr_len);
+	fmt_str(l, " P(");
+	fmt_u(l, fr->payload_len, 0);
+	fmt_str(l, ")=");
+	fmt_hex_bytes(l, fr->payload, fr->payload_len);
+}
+
+static void XN297Dump_print_basic(const dump_frame_t *f)
+{
+	uint32_t time = 0;
+	if (f->channel == decode_ch)
+		time = (uint32_t)(f->time - time_stamp);
+	decode_ch = f->channel;		/* first frame after a channel change reads 0us */
+	xn297_frame_t fr;
+	bool ok = XN297Dump_decode(&rx_decoder, f->data, &fr);
+	dump_stats_crc(f->channel, f->bitrate, ok);
+	if (dump_output_mode == DUMP_OUTPUT_BINARY) {
+		if (ok) {
+			uint8_t flags = DUMP_REC_F_CRC_OK | (fr.scramble ? DUMP_REC_F_SCRAMBLE : 0) |
+				(fr.enhanced ? DUMP_REC_F_ENHANCED : 0) | (fr.ack ? DUMP_REC_F_ACK : 0) |
+				DUMP_REC_F_OFFSET(fr.bit_offset);
+			time_stamp = f->time;
+			dump_output_frame(f->time, f->channel, f->bitrate, flags, fr.pid, fr.addr_len, fr.addr,
+				fr.addr_len + fr.payload_len);
+		} else
+			dump_output_frame(f->time, f->channel, f->bitrate, 0, 0, 0, NULL, 0);
+		return;
+	}
+	dump_line_t l;
+	fmt_begin(&l);
+	fmt_str(&l, "RX: ");
+	fmt_u(&l, time, 5);
+	fmt_str(&l, "us C=");
+	fmt_u(&l, f->channel, 0);
+	if (ok) {
+		time_stamp = f->time;
+		fmt_char(&l, ' ');
+		if (fr.bit_offset) {
+			fmt_str(&l, "Offset=");
+			fmt_i(&l, fr.bit_offset);
+			fmt_char(&l, ' ');
+		}
+		XN297Dump_fmt_decoded(&l, &fr);
+	} else {
+		fmt_str(&l, " Bad CRC");
+	}
+	fmt_emit(&l, 1);
+}
+
 static void XN297Dump_mode_nrf(void)
 {
 	if (phase == 0) {
@@ -270,34 +345,18 @@ static void XN297Dump_mode_nrf(void)
 		time_stamp = 0;
 	}
 	else {
-		if (NRF24L01_ReadReg(NRF24L01_07_STATUS) & _BV(NRF24L01_07_RX_DR)) {
-			if (NRF24L01_ReadReg(NRF24L01_09_CD)) {
-				XN297Dump_overflow();
-				uint16_t timeL = dump_platform_timer_get_cnt();
-				if (dump_platform_timer_overflow()) {
-					timeH++;
-					timeL = 0;
-				}
-				uint32_t time = ((uint32_t)timeH << 16) + timeL - time_stamp;
-				debug("RX: %5luus ", (unsigned long)(time >> 1));
-				time_stamp = ((uint32_t)timeH << 16) + timeL;
-				NRF24L01_ReadPayload(packet, packet_length);
-				debug("C: %02X P:", option);
-				for (uint8_t i = 0; i < packet_length; i++)
-					debug(" %02X", packet[i]);
-				debugln("");
-				memcpy(packet_in, packet, packet_length);
+		if (XN297Dump_rx_ready()) {
+			if (XN297Dump_rpd()) {
+				do
+					XN297Dump_capture(option, packet_length, false);
+				while (XN297Dump_rx_more());
 			}
-			NRF24L01_WriteReg(NRF24L01_07_STATUS, 0x70);
-			NRF24L01_SetTxRxMode(TXRX_OFF);
-			NRF24L01_SetTxRxMode(RX_EN);
-			NRF24L01_FlushRx();
-			NRF24L01_WriteReg(NRF24L01_00_CONFIG, _BV(NRF24L01_00_PWR_UP) | _BV(NRF24L01_00_PRIM_RX));
+			NRF24L01_RxRearm();
 		}
-		XN297Dump_overflow();
 		if (old_option != option) {
 			debugln("Channel changed to %d", option);
-			NRF24L01_WriteReg(NRF24L01_05_RF_CH, option);
+			NRF24L01_RxRetune(option, _BV(NRF24L01_00_PWR_UP) | _BV(NRF24L01_00_PRIM_RX));
+			XN297Dump_retuned(option);
 			old_option = option;
 		}
 	}
@@ -323,47 +382,74 @@ static void XN297Dump_mode_xn297(void)
 		time_stamp = 0;
 	}
 	else {
-		bool rx = XN297_IsRX();
+		bool rx = XN297Dump_rx_ready();
 		if (rx) {
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297Dump_overflow();
-			uint16_t timeL = dump_platform_timer_get_cnt();
-			if (dump_platform_timer_overflow()) {
-				timeH++;
-				timeL = 0;
-			}
-			uint32_t time = ((uint32_t)timeH << 16) + timeL - time_stamp;
-			debug("RX: %5luus ", (unsigned long)(time >> 1));
-			time_stamp = ((uint32_t)timeH << 16) + timeL;
-			if (XN297_ReadPayload(packet_in, packet_length)) {
-				debug("OK:");
-				for (uint8_t i = 0; i < packet_length; i++)
-					debug(" %02X", packet_in[i]);
-			} else {
-				debug(" NOK");
-			}
-			debugln("");
-			XN297_SetTxRxMode(RX_EN);
+			do
+				XN297Dump_capture(option, packet_length, true);
+			while (XN297Dump_rx_more());
+			XN297_RxRearm();
 		}
-		XN297Dump_overflow();
 		if (old_option != option) {
 			debugln("C=%d(%02X)", option, option);
-			XN297_Hopping(option);
+			XN297_RxRetune(option);
+			XN297Dump_retuned(option);
 			old_option = option;
 		}
 	}
 }
 
+static void XN297Dump_print_nrf(const dump_frame_t *f)
+{
+	memcpy(packet_in, f->data, f->len);
+	if (dump_output_mode == DUMP_OUTPUT_BINARY) {
+		dump_output_frame(f->time, f->channel, f->bitrate, DUMP_REC_F_CRC_OK, 0, 0, f->data, f->len);
+		return;
+	}
+	dump_line_t l;
+	fmt_begin(&l);
+	fmt_str(&l, "RX: ");
+	fmt_u(&l, (uint32_t)(f->time - time_stamp), 5);
+	time_stamp = f->time;
+	fmt_str(&l, "us C: ");
+	fmt_hex2(&l, f->channel);
+	fmt_str(&l, " P:");
+	fmt_hex_bytes(&l, f->data, f->len);
+	fmt_emit(&l, 1);
+}
+
+static void XN297Dump_print_xn297(const dump_frame_t *f)
+{
+	memcpy(packet_in, f->data, f->len);
+	dump_stats_crc(f->channel, f->bitrate, f->flags & DUMP_FRAME_CRC_OK);
+	if (dump_output_mode == DUMP_OUTPUT_BINARY) {
+		dump_output_frame(f->time, f->channel, f->bitrate, f->flags & DUMP_FRAME_CRC_OK ? DUMP_REC_F_CRC_OK : 0,
+			0, 0, f->data, f->len);
+		return;
+	}
+	dump_line_t l;
+	fmt_begin(&l);
+	fmt_str(&l, "RX: ");
+	fmt_u(&l, (uint32_t)(f->time - time_stamp), 5);
+	time_stamp = f->time;
+	if (f->flags & DUMP_FRAME_CRC_OK) {
+		fmt_str(&l, "us OK:");
+		fmt_hex_bytes(&l, f->data, f->len);
+	} else {
+		fmt_str(&l, "us  NOK");
+	}
+	fmt_emit(&l, 1);
+}
+
 static void XN297Dump_mode_auto(void)
 {
 	switch (phase) {
 	case 0:
 		debugln("------------------------");
 		debugln("Detecting XN297 packets.");
+		bitrate = 0;			/* before RF_init: the scan and its label start at 250K */
 		XN297Dump_RF_init();
 		debug("Trying RF channel: 0");
 		hopping_frequency_no = 0;
-		bitrate = 0;
 		phase++;
 		break;
 	case 1:
@@ -372,6 +458,7 @@ static void XN297Dump_mode_auto(void)
 			bind_counter = 0;
 			if (hopping_frequency_no > XN297DUMP_MAX_RF_CHANNEL) {
 				hopping_frequency_no = 0;
+				dump_stats.sweeps++;
 				bitrate++;
 				bitrate %= 3;
 				debugln("");
@@ -380,68 +467,70 @@ static void XN297Dump_mode_auto(void)
 			}
 			if (hopping_frequency_no)
 				debug(",%d", hopping_frequency_no);
-			NRF24L01_WriteReg(NRF24L01_05_RF_CH, hopping_frequency_no);
-			NRF24L01_WriteReg(NRF24L01_07_STATUS, 0x70);
-			NRF24L01_SetTxRxMode(TXRX_OFF);
-			NRF24L01_SetTxRxMode(RX_EN);
-			NRF24L01_FlushRx();
-			NRF24L01_WriteReg(NRF24L01_00_CONFIG, (0 << NRF24L01_00_EN_CRC) | (1 << NRF24L01_00_CRCO) | (1 << NRF24L01_00_PWR_UP) | (1 << NRF24L01_00_PRIM_RX));
+			NRF24L01_RxRetune(hopping_frequency_no, XN297DUMP_RX_CONFIG);
+			XN297Dump_retuned(hopping_frequency_no);
 		}
-		if (NRF24L01_ReadReg(NRF24L01_07_STATUS) & _BV(NRF24L01_07_RX_DR)) {
-			if (NRF24L01_ReadReg(NRF24L01_09_CD)) {
-				NRF24L01_ReadPayload(packet, XN297DUMP_MAX_PACKET_LEN);
-				if (XN297Dump_process_packet()) {
-					debug("\r\n\r\nPacket detected: bitrate=");
-					switch (bitrate) {
-					case XN297DUMP_250K:
-						XN297_Configure(XN297_CRCEN, scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_250K);
-						debug("250K");
-						break;
-					case XN297DUMP_2M:
-						XN297_Configure(XN297_CRCEN, scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_1M);
-						NRF24L01_SetBitrate(NRF24L01_BR_2M);
-						debug("2M");
-						break;
-					default:
-						XN297_Configure(XN297_CRCEN, scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_1M);
-						debug("1M");
-						break;
-					}
-					debug(" C=%d ", hopping_frequency_no);
-					if (enhanced) {
-						debug("Enhanced ");
-						debug("pid=%d ", pid);
-						if (ack) debug("ack ");
-					}
-					debug("S=%c A=", scramble ? 'Y' : 'N');
-					for (uint8_t i = 0; i < address_length; i++) {
-						debug(" %02X", packet[i]);
-						rx_tx_addr[i] = packet[i];
-					}
-					debug(" P(%d)=", packet_length - address_length);
-					for (uint8_t i = address_length; i < packet_length; i++)
-						debug(" %02X", packet[i]);
-					packet_length = packet_length - address_length;
-					debugln("\r\n--------------------------------");
-					debugln("Identifying all RF channels in use.");
-					bind_counter = 0;
-					hopping_frequency_no = 0;
-					rf_ch_num = 0;
-					packet_count = 0;
-					nbr_rf = (uint8_t *)malloc(XN297DUMP_MAX_RF_CHANNEL * sizeof(uint8_t));
-					if (nbr_rf == NULL) {
-						debugln("\r\nCan't allocate memory for next phase!!!");
-						phase = 0;
-						break;
+		if (XN297Dump_rx_ready()) {
+			if (XN297Dump_rpd()) {
+				do {
+					uint8_t raw[XN297_RAW_LEN];
+					xn297_frame_t fr;
+					NRF24L01_ReadPayload(raw, XN297_RAW_LEN);
+					bool ok = XN297Dump_decode(&scan_decoder, raw, &fr);
+					dump_stats_crc(hopping_frequency_no, bitrate, ok);
+					if (ok) {
+						enhanced = fr.enhanced;
+						address_length = fr.addr_len;
+						dump_line_t l;
+						fmt_begin(&l);
+						fmt_str(&l, "\r\n\r\nPacket detected: bitrate=");
+						switch (bitrate) {
+						case XN297DUMP_250K:
+							XN297_Configure(XN297_CRCEN, fr.scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_250K);
+							fmt_str(&l, "250K");
+							break;
+						case XN297DUMP_2M:
+							XN297_Configure(XN297_CRCEN, fr.scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_1M);
+							NRF24L01_SetBitrate(NRF24L01_BR_2M);
+							fmt_str(&l, "2M");
+							break;
+						default:
+							XN297_Configure(XN297_CRCEN, fr.scramble ? XN297_SCRAMBLED : XN297_UNSCRAMBLED, XN297_1M);
+							fmt_str(&l, "1M");
+							break;
+						}
+						fmt_str(&l, " C=");
+						fmt_u(&l, hopping_frequency_no, 0);
+						fmt_char(&l, ' ');
+						if (fr.bit_offset) {
+							fmt_str(&l, "Offset=");
+							fmt_i(&l, fr.bit_offset);
+							fmt_char(&l, ' ');
+						}
+						XN297Dump_fmt_decoded(&l, &fr);
+						fmt_emit(&l, 0);
+						memcpy(rx_tx_addr, fr.addr, address_length);
+						packet_length = fr.payload_len;
+						debugln("\r\n--------------------------------");
+						debugln("Identifying all RF channels in use.");
+						bind_counter = 0;
+						hopping_frequency_no = 0;
+						rf_ch_num = 0;
+						packet_count = 0;
+						nbr_rf = (uint8_t *)malloc(XN297DUMP_MAX_RF_CHANNEL * sizeof(uint8_t));
+						if (nbr_rf == NULL) {
+							debugln("\r\nCan't allocate memory for next phase!!!");
+							phase = 0;
+							break;
+						}
+						debug("Trying RF channel: 0");
+						XN297_SetTXAddr(rx_tx_addr, address_length);
+						XN297_SetRXAddr(rx_tx_addr, packet_length);
+						XN297_RxRetune(0);
+						XN297Dump_retuned(0);
+						phase = 2;
 					}
-					debug("Trying RF channel: 0");
-					XN297_SetTXAddr(rx_tx_addr, address_length);
-					XN297_SetRXAddr(rx_tx_addr, packet_length);
-					XN297_RFChannel(0);
-					XN297_SetTxRxMode(TXRX_OFF);
-					XN297_SetTxRxMode(RX_EN);
-					phase = 2;
-				}
+				} while (phase == 1 && XN297Dump_rx_more());
 			}
 		}
 		break;
@@ -454,6 +543,7 @@ static void XN297Dump_mode_auto(void)
 			packet_count = 0;
 			if (hopping_frequency_no > XN297DUMP_MAX_RF_CHANNEL) {
 				uint8_t nbr_max = 0, j = 0;
+				dump_stats.sweeps++;
 				debug("\r\n\r\n%d RF channels identified:", rf_ch_num);
 				compare_channel = 0;
 				for (uint8_t i = 0; i < rf_ch_num; i++) {
@@ -492,61 +582,48 @@ static void XN297Dump_mode_auto(void)
 				bind_counter = 0;
 				debugln("Time between CH:%d and CH:%d", hopping_frequency[compare_channel], hopping_frequency[hopping_frequency_no]);
 				time_rf[hopping_frequency_no] = 0xFFFFFFFF;
-				XN297_RFChannel(hopping_frequency[compare_channel]);
-				uint16_t timeL = dump_platform_timer_get_cnt();
-				if (dump_platform_timer_overflow()) {
-					timeH++;
-					timeL = 0;
-				}
-				time_stamp = ((uint32_t)timeH << 16) + timeL;
-				XN297_SetTxRxMode(TXRX_OFF);
-				XN297_SetTxRxMode(RX_EN);
-				XN297Dump_overflow();
+				time_stamp = XN297Dump_now();
+				XN297_RxRetune(hopping_frequency[compare_channel]);
+				XN297Dump_retuned(hopping_frequency[compare_channel]);
 				break;
 			}
 			debug(",%d", hopping_frequency_no);
-			XN297_RFChannel(hopping_frequency_no);
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297_SetTxRxMode(RX_EN);
+			XN297_RxRetune(hopping_frequency_no);
+			XN297Dump_retuned(hopping_frequency_no);
 		}
-		if (XN297_IsRX()) {
-			if (NRF24L01_ReadReg(NRF24L01_09_CD)) {
-				uint8_t res;
-				if (enhanced) {
-					res = XN297_ReadEnhancedPayload(packet, packet_length);
-					res++;
-				} else
-					res = XN297_ReadPayload(packet, packet_length);
-				if (res) {
-					XN297Dump_overflow();
-					uint16_t timeL = dump_platform_timer_get_cnt();
-					if (dump_platform_timer_overflow()) {
-						timeH++;
-						timeL = 0;
-					}
-					uint32_t time;
-					if (packet_count == 0) {
-						hopping_frequency[rf_ch_num] = hopping_frequency_no;
-						rf_ch_num++;
-						time = 0;
-					} else
-						time = ((uint32_t)timeH << 16) + timeL - time_stamp;
-					debug("\r\nRX on channel: %d, Time: %5luus P:", hopping_frequency_no, (unsigned long)(time >> 1));
-					time_stamp = ((uint32_t)timeH << 16) + timeL;
-					for (uint8_t i = 0; i < packet_length; i++)
-						debug(" %02X", packet[i]);
-					packet_count++;
-					nbr_rf[rf_ch_num - 1] = packet_count;
-					if (packet_count > 20) {
-						bind_counter = XN297DUMP_PERIOD_SCAN + 1;
-						debug("\r\nTrying RF channel: ");
+		if (XN297Dump_rx_ready()) {
+			if (XN297Dump_rpd()) {
+				do {
+					if (XN297Dump_read_xn297()) {
+						uint64_t now = XN297Dump_frame_time();
+						uint32_t time;
+						if (packet_count == 0) {
+							hopping_frequency[rf_ch_num] = hopping_frequency_no;
+							rf_ch_num++;
+							time = 0;
+						} else
+							time = (uint32_t)(now - time_stamp);
+						dump_line_t l;
+						fmt_begin(&l);
+						fmt_str(&l, "\r\nRX on channel: ");
+						fmt_u(&l, hopping_frequency_no, 0);
+						fmt_str(&l, ", Time: ");
+						fmt_u(&l, time, 5);
+						fmt_str(&l, "us P:");
+						fmt_hex_bytes(&l, packet, packet_length);
+						fmt_emit(&l, 0);
+						time_stamp = now;
+						packet_count++;
+						nbr_rf[rf_ch_num - 1] = packet_count;
+						if (packet_count > 20) {
+							bind_counter = XN297DUMP_PERIOD_SCAN + 1;
+							debug("\r\nTrying RF channel: ");
+						}
 					}
-				}
+				} while (packet_count <= 20 && XN297Dump_rx_more());
 			}
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297_SetTxRxMode(RX_EN);
+			XN297_RxRearm();
 		}
-		XN297Dump_overflow();
 		break;
 	case 3:
 		if (bind_counter > XN297DUMP_PERIOD_SCAN) {
@@ -582,40 +659,25 @@ static void XN297Dump_mode_auto(void)
 			}
 			debugln("Time between CH:%d and CH:%d", hopping_frequency[compare_channel], hopping_frequency[hopping_frequency_no]);
 			time_rf[hopping_frequency_no] = 0xFFFFFFFF;
-			XN297_RFChannel(hopping_frequency[compare_channel]);
-			uint16_t timeL = dump_platform_timer_get_cnt();
-			if (dump_platform_timer_overflow()) {
-				timeH++;
-				timeL = 0;
-			}
-			time_stamp = ((uint32_t)timeH << 16) + timeL;
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297_SetTxRxMode(RX_EN);
+			time_stamp = XN297Dump_now();
+			XN297_RxRetune(hopping_frequency[compare_channel]);
+			XN297Dump_retuned(hopping_frequency[compare_channel]);
 		}
-		if (XN297_IsRX()) {
-			if (NRF24L01_ReadReg(NRF24L01_09_CD)) {
-				uint8_t res;
-				if (enhanced) {
-					res = XN297_ReadEnhancedPayload(packet, packet_length);
-					res++;
-				} else
-					res = XN297_ReadPayload(packet, packet_length);
-				if (res) {
-					XN297Dump_overflow();
-					uint16_t timeL = dump_platform_timer_get_cnt();
-					if (dump_platform_timer_overflow()) {
-						timeH++;
-						timeL = 0;
-					}
+		if (XN297Dump_rx_ready()) {
+			uint8_t next_ch = 0xFF;
+			if (XN297Dump_rpd()) {
+				/* No FIFO drain here: the timing pairs rely on one frame per channel switch */
+				if (XN297Dump_read_xn297()) {
+					uint64_t now = XN297Dump_frame_time();
 					if (packet_count & 1) {
-						uint32_t time = ((uint32_t)timeH << 16) + timeL - time_stamp;
-						if (time_rf[hopping_frequency_no] > (time >> 1))
-							time_rf[hopping_frequency_no] = time >> 1;
-						debugln("Time: %5luus", (unsigned long)(time >> 1));
-						XN297_RFChannel(hopping_frequency[compare_channel]);
+						uint32_t time = (uint32_t)(now - time_stamp);
+						if (time_rf[hopping_frequency_no] > time)
+							time_rf[hopping_frequency_no] = time;
+						debugln("Time: %5luus", (unsigned long)time);
+						next_ch = hopping_frequency[compare_channel];
 					} else {
-						time_stamp = ((uint32_t)timeH << 16) + timeL;
-						XN297_RFChannel(hopping_frequency[hopping_frequency_no]);
+						time_stamp = now;
+						next_ch = hopping_frequency[hopping_frequency_no];
 					}
 					packet_count++;
 					if (packet_count > 24) {
@@ -624,41 +686,74 @@ static void XN297Dump_mode_auto(void)
 					}
 				}
 			}
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297_SetTxRxMode(RX_EN);
+			if (next_ch != 0xFF) {
+				XN297_RxRetune(next_ch);
+				XN297Dump_retuned(next_ch);
+			} else
+				XN297_RxRearm();
 		}
-		XN297Dump_overflow();
 		break;
 	case 4:
-		if (XN297_IsRX()) {
-			uint8_t res;
-			if (enhanced) {
-				res = XN297_ReadEnhancedPayload(packet, packet_length);
-				res++;
-			} else
-				res = XN297_ReadPayload(packet, packet_length);
-			if (res) {
-				if (memcmp(packet_in, packet, packet_length)) {
-					debug("P:");
-					for (uint8_t i = 0; i < packet_length; i++)
-						debug(" %02X", packet[i]);
-					debugln("");
-					memcpy(packet_in, packet, packet_length);
+		if (XN297Dump_rx_ready()) {
+			do {
+				if (XN297Dump_read_xn297()) {
+					if (memcmp(packet_in, packet, packet_length)) {
+						dump_line_t l;
+						fmt_begin(&l);
+						fmt_str(&l, "P:");
+						fmt_hex_bytes(&l, packet, packet_length);
+						fmt_emit(&l, 1);
+						memcpy(packet_in, packet, packet_length);
+					}
 				}
-			}
-			XN297_SetTxRxMode(TXRX_OFF);
-			XN297_SetTxRxMode(RX_EN);
+			} while (XN297Dump_rx_more());
+			XN297_RxRearm();
 		}
 		break;
 	}
 	bind_counter++;
 }
 
-void XN297Dump_step(void)
+/* Decode/print stage: one frame per loop so the capture stage gets a turn between lines */
+static void XN297Dump_drain(void)
 {
-	if (!cli_dump_running)
+	const dump_frame_t *f = dump_capture_peek();
+	if (f == NULL)
+		return;
+	if (f->flags & DUMP_FRAME_CHANNEL) {
+		debugln("Channel=%d,0x%02X", f->channel, f->channel);
+		dump_capture_release();
+		return;
+	}
+	DUMP_PROF_BEGIN(DUMP_PROF_DRAIN);
+	uint32_t t0 = (uint32_t)XN297Dump_now();
+	dump_pipe.depth_sum += dump_capture_used();
+	dump_pipe_account(&dump_pipe.wait_sum, &dump_pipe.wait_max, t0 - f->queued);
+	switch (sub_protocol) {
+	case XN297DUMP_NRF:
+		XN297Dump_print_nrf(f);
+		break;
+	case XN297DUMP_XN297:
+		XN297Dump_print_xn297(f);
+		break;
+	default:
+		XN297Dump_print_basic(f);
+		break;
+	}
+	dump_capture_release();
+	dump_pipe_account(&dump_pipe.output_sum, &dump_pipe.output_max, (uint32_t)XN297Dump_now() - t0);
+	dump_pipe.frames++;
+	DUMP_PROF_END(DUMP_PROF_DRAIN);
+}
+
+/* Radio stage: capture into the ring (Auto mode also decodes and prints here) */
+static void XN297Dump_radio_step(void)
+{
+	/* Radio still settling: give the loop back to the CLI instead of spinning */
+	if (!NRF24L01_RxReady())
 		return;
 	
+	DUMP_PROF_BEGIN(DUMP_PROF_RADIO);
 	switch (sub_protocol) {
 	case XN297DUMP_250K:
 	case XN297DUMP_1M:
@@ -678,19 +773,96 @@ void XN297Dump_step(void)
 		XN297Dump_mode_basic();
 		break;
 	}
-	XN297Dump_overflow();
+	DUMP_PROF_END(DUMP_PROF_RADIO);
+}
+
+/* Frames both decoders only decoded after re-alignment since the last (re)start ('stats') */
+uint32_t XN297Dump_offset_recovered(void)
+{
+	return rx_decoder.offset_recovered + scan_decoder.offset_recovered;
+}
+
+void XN297Dump_step(void)
+{
+	if (!cli_dump_running)
+		return;
+	/* Frames already captured are printed even while the radio settles */
+	XN297Dump_drain();
+	XN297Dump_radio_step();
+}
+
+/* Radio task (dual-core builds): one radio step per call unless the main loop holds the radio */
+static int XN297Dump_radio_task(void)
+{
+	if (__atomic_load_n(&radio_hold, __ATOMIC_ACQUIRE)) {
+		if (!__atomic_load_n(&radio_held, __ATOMIC_RELAXED)) {
+			__atomic_store_n(&radio_held, 1, __ATOMIC_RELEASE);
+			dump_platform_capture_task_ack();
+		}
+		dump_platform_capture_task_park();
+		return 1;
+	}
+	if (__atomic_load_n(&radio_held, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&radio_held, 0, __ATOMIC_RELEASE);
+		dump_platform_capture_task_ack();
+	}
+	if (!cli_dump_running)
+		return 0;
+	XN297Dump_radio_step();
+	return 1;
+}
+
+/*
+ * Park the radio task between steps (hold) or wake it again, and sleep until
+ * it acknowledges. A notification left over from an earlier timeout only
+ * costs one more wait. Returns 0 if the radio task did not park in time: the
+ * hold is withdrawn and the radio is not the caller's.
+ */
+static uint8_t XN297Dump_hold_radio(uint8_t hold)
+{
+	if (dump_pipe_core < 0)
+		return 1;
+	__atomic_store_n(&radio_hold, hold, __ATOMIC_RELEASE);
+	if (!hold)
+		dump_platform_capture_task_wake();
+	while (__atomic_load_n(&radio_held, __ATOMIC_ACQUIRE) != hold)
+		if (!dump_platform_capture_task_wait_ack(XN297DUMP_HOLD_TIMEOUT_MS)) {
+			dump_pipe.hold_timeouts++;
+			if (hold) {
+				__atomic_store_n(&radio_hold, 0, __ATOMIC_RELEASE);
+				dump_platform_capture_task_wake();
+			}
+			return 0;
+		}
+	return 1;
 }
 
 void XN297Dump_run(void)
 {
+	dump_pipe_core = (int8_t)dump_platform_capture_task_start(XN297Dump_radio_task);
 	for (;;) {
-		cli_process();
-		
-		if (cli_restart_requested()) {
-			cli_clear_restart();
-			XN297Dump_init();
+		DUMP_PROF_BEGIN(DUMP_PROF_LOOP);
+		dump_stats.loops++;
+		/* The CLI and restart touch the radio: only while the radio task is parked */
+		if ((dump_platform_serial_available() || cli_restart_requested()) && XN297Dump_hold_radio(1)) {
+			DUMP_PROF_BEGIN(DUMP_PROF_CLI);
+			cli_process();
+			DUMP_PROF_END(DUMP_PROF_CLI);
+			if (cli_restart_requested()) {
+				cli_clear_restart();
+				XN297Dump_init();
+			}
+			XN297Dump_hold_radio(0);
 		}
 		
-		XN297Dump_step();
+		if (dump_pipe_core < 0)
+			XN297Dump_step();
+		else if (cli_dump_running)
+			XN297Dump_drain();
+		DUMP_PROF_BEGIN(DUMP_PROF_TX);
+		dump_platform_tx_poll();
+		DUMP_PROF_END(DUMP_PROF_TX);
+		cli_stats_poll();
+		DUMP_PROF_END(DUMP_PROF_LOOP);
 	}
 }
@@ -1,78 +1,28 @@
 /*
- * XN297 emulation (NRF24L01 only) and tables.
+ * XN297 emulation (NRF24L01 only). Tables are in xn297_decode.c.
  * From Multiprotocol/XN297_EMU.ino
  */
 #include "../include/iface_xn297.h"
 #include "../include/dump_types.h"
 #include "../include/dump_platform.h"
+#include "../include/xn297_tables.h"
 #include <string.h>
 
 #define XN297_NRF false
 #define xn297_rf  XN297_NRF  /* always NRF in this build */
 
-bool xn297_scramble_enabled;
-bool xn297_crc;
-bool xn297_bitrate;
-uint8_t xn297_addr_len;
-uint8_t xn297_rx_packet_len;
-uint8_t xn297_tx_addr[5];
-uint8_t xn297_rx_addr[5];
-
-/* Exported for XN297Dump_process_packet (39 bytes, match original); extern "C" + extern for external linkage */
-#ifdef __cplusplus
-extern "C" {
-#endif
-extern const uint8_t xn297_scramble[39] = {
-	0xE3, 0xB1, 0x4B, 0xEA, 0x85, 0xBC, 0xE5, 0x66,
-	0x0D, 0xAE, 0x8C, 0x88, 0x12, 0x69, 0xEE, 0x1F,
-	0xC7, 0x62, 0x97, 0xD5, 0x0B, 0x79, 0xCA, 0xCC,
-	0x1B, 0x5D, 0x19, 0x10, 0x24, 0xD3, 0xDC, 0x3F,
-	0x8E, 0xC5, 0x2F, 0xAA, 0x16, 0xF3, 0x95
-};
-
-extern const uint16_t xn297_crc_xorout_scrambled[35] = {
-	0x0000, 0x3448, 0x9BA7, 0x8BBB, 0x85E1, 0x3E8C,
-	0x451E, 0x18E6, 0x6B24, 0xE7AB, 0x3828, 0x814B,
-	0xD461, 0xF494, 0x2503, 0x691D, 0xFE8B, 0x9BA7,
-	0x8B17, 0x2920, 0x8B5F, 0x61B1, 0xD391, 0x7401,
-	0x2138, 0x129F, 0xB3A0, 0x2988, 0x23CA, 0xC0CB,
-	0x0C6C, 0xB329, 0xA0A1, 0x0A16, 0xA9D0
-};
-
-extern const uint16_t xn297_crc_xorout[35] = {
-	0x0000, 0x3D5F, 0xA6F1, 0x3A23, 0xAA16, 0x1CAF,
-	0x62B2, 0xE0EB, 0x0821, 0xBE07, 0x5F1A, 0xAF15,
-	0x4F0A, 0xAD24, 0x5E48, 0xED34, 0x068C, 0xF2C9,
-	0x1852, 0xDF36, 0x129D, 0xB17C, 0xD5F5, 0x70D7,
-	0xB798, 0x5133, 0x67DB, 0xD94E, 0x0A5B, 0xE445,
-	0xE6A5, 0x26E7, 0xBDAB, 0xC379, 0x8E20
-};
-
-extern const uint16_t xn297_crc_xorout_scrambled_enhanced[35] = {
-	0x0000, 0x7EBF, 0x3ECE, 0x07A4, 0xCA52, 0x343B,
-	0x53F8, 0x8CD0, 0x9EAC, 0xD0C0, 0x150D, 0x5186,
-	0xD251, 0xA46F, 0x8435, 0xFA2E, 0x7EBD, 0x3C7D,
-	0x94E0, 0x3D5F, 0xA685, 0x4E47, 0xF045, 0xB483,
-	0x7A1F, 0xDEA2, 0x9642, 0xBF4B, 0x032F, 0x01D2,
-	0xDC86, 0x92A5, 0x183A, 0xB760, 0xA953
-};
-
-extern const uint16_t xn297_crc_xorout_enhanced[35] = {
-	0x0000, 0x8BE6, 0xD8EC, 0xB87A, 0x42DC, 0xAA89,
-	0x83AF, 0x10E4, 0xE83E, 0x5C29, 0xAC76, 0x1C69,
-	0xA4B2, 0x5961, 0xB4D3, 0x2A50, 0xCB27, 0x5128,
-	0x7CDB, 0x7A14, 0xD5D2, 0x57D7, 0xE31D, 0xCE42,
-	0x648D, 0xBF2D, 0x653B, 0x190C, 0x9117, 0x9A97,
-	0xABFC, 0xE68E, 0x0DE7, 0x28A2, 0x1965
-};
-#ifdef __cplusplus
-}
-#endif
+static bool    xn297_scramble_enabled;
+static bool    xn297_crc;
+static bool    xn297_bitrate;
+static uint8_t xn297_addr_len;
+static uint8_t xn297_rx_packet_len;
+static uint8_t xn297_tx_addr[5];
+static uint8_t xn297_rx_addr[5];
+static uint16_t xn297_crc_addr;	/* CRC state after the RX address, set by XN297_SetRXAddr */
 
 #define pgm_read_word(addr) (*(const uint16_t *)(addr))
 
 extern uint8_t bit_reverse(uint8_t);
-extern void crc16_update(uint8_t a, uint8_t bits);
 
 void XN297_Configure(bool crc_en, bool scramble_en, bool bitrate, bool force_nrf)
 {
@@ -92,7 +42,10 @@ void XN297_SetTXAddr(const uint8_t *addr, uint8_t len)
 	memcpy(xn297_tx_addr, addr, len);
 	uint8_t buf[] = { 0x55, 0x0F, 0x71, 0x0C, 0x00 };
 	NRF24L01_WriteReg(NRF24L01_03_SETUP_AW, len - 2);
-	NRF24L01_WriteRegisterMulti(NRF24L01_10_TX_ADDR, xn297_addr_len == 3 ? (uint8_t*)(buf+1) : (uint8_t*)buf, 5);
+	if (xn297_addr_len == 3)
+		NRF24L01_WriteRegisterMulti(NRF24L01_10_TX_ADDR, buf + 1, 4);
+	else
+		NRF24L01_WriteRegisterMulti(NRF24L01_10_TX_ADDR, buf, 5);
 }
 
 void XN297_SetRXAddr(const uint8_t *addr, uint8_t rx_packet_len)
@@ -102,6 +55,9 @@ void XN297_SetRXAddr(const uint8_t *addr, uint8_t rx_packet_len)
 		if (xn297_scramble_enabled)
 			xn297_rx_addr[i] ^= xn297_scramble[xn297_addr_len - i - 1];
 	}
+	xn297_crc_addr = 0xb5d2;
+	for (uint8_t i = 0; i < xn297_addr_len; ++i)
+		xn297_crc_addr = crc16_ccitt_byte(xn297_crc_addr, xn297_rx_addr[xn297_addr_len - i - 1]);
 	if (xn297_crc) rx_packet_len += 2;
 	rx_packet_len += 2;
 	if (rx_packet_len > 32) rx_packet_len = 32;
@@ -129,9 +85,20 @@ void XN297_SetTxRxMode(enum TXRX_State mode)
 	dump_platform_nrf_ce_high();
 }
 
+/* Fast RX path: chip stays powered up, see NRF24L01_RxRetune */
+void XN297_RxRetune(uint8_t number)
+{
+	NRF24L01_RxRetune(number, (1 << NRF24L01_00_PWR_UP) | (1 << NRF24L01_00_PRIM_RX));
+}
+
+void XN297_RxRearm(void)
+{
+	NRF24L01_RxRearm();
+}
+
 bool XN297_IsRX(void)
 {
-	return (NRF24L01_ReadReg(NRF24L01_07_STATUS) & _BV(NRF24L01_07_RX_DR));
+	return (NRF24L01_Nop() & _BV(NRF24L01_07_RX_DR));
 }
 
 static void XN297_ReceivePayload(uint8_t *msg, uint8_t len)
@@ -144,18 +111,9 @@ bool XN297_ReadPayload(uint8_t *msg, uint8_t len)
 {
 	uint8_t buf[32];
 	XN297_ReceivePayload(buf, len);
-	for (uint8_t i = 0; i < len; i++) {
-		uint8_t b_in = buf[i];
-		if (xn297_scramble_enabled)
-			b_in ^= xn297_scramble[i + xn297_addr_len];
-		msg[i] = bit_reverse(b_in);
-	}
+	xn297_descramble_reverse(msg, buf, xn297_scramble_enabled ? xn297_scramble + xn297_addr_len : NULL, len);
 	if (!xn297_crc) return true;
-	crc = 0xb5d2;
-	for (uint8_t i = 0; i < xn297_addr_len; ++i)
-		crc16_update(xn297_rx_addr[xn297_addr_len - i - 1], 8);
-	for (uint8_t i = 0; i < len; ++i)
-		crc16_update(buf[i], 8);
+	uint16_t crc = crc16_ccitt_block(xn297_crc_addr, buf, len);
 	if (xn297_scramble_enabled)
 		crc ^= xn297_crc_xorout_scrambled[xn297_addr_len - 3 + len];
 	else
@@ -173,18 +131,11 @@ uint8_t XN297_ReadEnhancedPayload(uint8_t *msg, uint8_t len)
 		pcf_size ^= xn297_scramble[xn297_addr_len];
 	pcf_size >>= 1;
 	if (pcf_size > 32) return 255;
-	for (uint8_t i = 0; i < pcf_size; i++) {
-		msg[i] = bit_reverse((buffer[i + 1] << 2) | (buffer[i + 2] >> 6));
-		if (xn297_scramble_enabled)
-			msg[i] ^= bit_reverse((xn297_scramble[xn297_addr_len + i + 1] << 2) | (xn297_scramble[xn297_addr_len + i + 2] >> 6));
-	}
+	xn297_descramble_reverse_shift2(msg, buffer + 1,
+		xn297_scramble_enabled ? xn297_scramble + xn297_addr_len + 1 : NULL, pcf_size);
 	if (!xn297_crc) return pcf_size;
-	crc = 0xb5d2;
-	for (uint8_t i = 0; i < xn297_addr_len; ++i)
-		crc16_update(xn297_rx_addr[xn297_addr_len - i - 1], 8);
-	for (uint8_t i = 0; i < pcf_size + 1; ++i)
-		crc16_update(buffer[i], 8);
-	crc16_update(buffer[pcf_size + 1] & 0xc0, 2);
+	uint16_t crc = crc16_ccitt_block(xn297_crc_addr, buffer, pcf_size + 1);
+	crc = crc16_ccitt_2bits(crc, buffer[pcf_size + 1]);
 	if (xn297_scramble_enabled)
 		crc ^= xn297_crc_xorout_scrambled_enhanced[xn297_addr_len - 3 + pcf_size];
 	else
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Build the format-ID table for tokenized logging (include/dump_log.h).
+
+Collects the string literal formats of every debug/debugln and
+dump_platform_debug/debugln call in src/, hashes them with the same
+FNV-1a as dump_fmt_hash(), and writes {"<id hex>": "<format>"} as JSON
+for tools/xn297dump_decode.py --fmt-table. Two different formats with
+the same ID fail the build.
+
+Runs as a PlatformIO pre script (extra_scripts, output in $BUILD_DIR)
+or standalone:
+  gen_fmt_table.py [-o dump_fmt.json] [src_dir]
+"""
+import json
+import os
+import re
+import sys
+
+CALL = re.compile(r'\b(?:dump_platform_)?debug(?:ln)?\s*\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "\\": "\\", '"': '"', "'": "'", "0": "\0"}
+
+
+def fnv1a(s):
+    h = 2166136261
+    for b in s.encode("latin-1"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def unescape(lit):
+    return re.sub(r'\\(x[0-9A-Fa-f]{1,2}|.)',
+                  lambda m: chr(int(m.group(1)[1:], 16)) if m.group(1)[0] == "x" else ESCAPES.get(m.group(1), m.group(1)),
+                  lit)
+
+
+def collect(src_dir):
+    table = {}
+    for name in sorted(os.listdir(src_dir)):
+        if not name.endswith((".c", ".cpp")):
+            continue
+        with open(os.path.join(src_dir, name), encoding="latin-1") as f:
+            code = f.read()
+        for m in CALL.finditer(code):
+            fmt = "".join(unescape(l) for l in LITERAL.findall(m.group(1)))
+            fid = fnv1a(fmt)
+            if table.get(fid, fmt) != fmt:
+                raise SystemExit("gen_fmt_table: ID %08X collision in %s: %r vs %r" % (fid, name, fmt, table[fid]))
+            table[fid] = fmt
+    return table
+
+
+def write(table, path):
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w") as f:
+        json.dump({"%08X" % k: v for k, v in sorted(table.items())}, f, indent=0)
+
+
+try:
+    Import("env")  # noqa: F821 - PlatformIO/SCons
+    _table = collect(os.path.join(env["PROJECT_DIR"], "src"))  # noqa: F821
+    write(_table, os.path.join(env.subst("$BUILD_DIR"), "dump_fmt.json"))  # noqa: F821
+    print("gen_fmt_table: %d formats" % len(_table))
+except NameError:
+    if __name__ == "__main__":
+        import argparse
+        ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+        ap.add_argument("src", nargs="?", default=os.path.join(os.path.dirname(__file__), "..", "src"))
+        ap.add_argument("-o", "--output", default="dump_fmt.json")
+        args = ap.parse_args()
+        t = collect(args.src)
+        write(t, args.output)
+        sys.stderr.write("%d formats -> %s\n" % (len(t), args.output))
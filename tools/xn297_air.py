@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Write air scripts for the native simulation (env native, src/platform_native.cpp).
+
+Builds XN297 frames (standard/enhanced, scrambled or not) and plain
+NRF24L01 frames bit-exact as they go on air, and emits one transmitter
+sending them periodically, optionally hopping, as
+'<t_us> air <ch> <rate> <hex>' lines. Scripts from several runs can be
+merged with sort -n; tools/xn297_scenario.py does that for whole
+scenarios and scores the run.
+
+  xn297_air.py --addr C0FFEE --len 16 --scramble --ch 40 > air.txt
+  xn297_air.py --addr C0FFEE --len 16 --ch 5,22,41,60 --period 4000 >> air.txt
+  xn297_air.py --nrf --addr E7E7E7E7E7 --len 8 --crc 2 --ch 5 --start 2000 >> air.txt
+  sort -n -o air.txt air.txt
+  .pio/build/native/program -s air.txt
+"""
+import argparse
+import random
+
+XN297_PREAMBLE = bytes([0x71, 0x0F, 0x55])
+XN297_SCRAMBLE = [
+    0xE3, 0xB1, 0x4B, 0xEA, 0x85, 0xBC, 0xE5, 0x66, 0x0D, 0xAE, 0x8C, 0x88, 0x12, 0x69, 0xEE, 0x1F,
+    0xC7, 0x62, 0x97, 0xD5, 0x0B, 0x79, 0xCA, 0xCC, 0x1B, 0x5D, 0x19, 0x10, 0x24, 0xD3, 0xDC, 0x3F,
+    0x8E, 0xC5, 0x2F, 0xAA, 0x16, 0xF3, 0x95]
+# CRC xorout by address + payload length - 3, from src/xn297_decode.c
+XN297_XOROUT = {
+    (False, False): [
+        0x0000, 0x3D5F, 0xA6F1, 0x3A23, 0xAA16, 0x1CAF, 0x62B2, 0xE0EB, 0x0821, 0xBE07, 0x5F1A, 0xAF15,
+        0x4F0A, 0xAD24, 0x5E48, 0xED34, 0x068C, 0xF2C9, 0x1852, 0xDF36, 0x129D, 0xB17C, 0xD5F5, 0x70D7,
+        0xB798, 0x5133, 0x67DB, 0xD94E, 0x0A5B, 0xE445, 0xE6A5, 0x26E7, 0xBDAB, 0xC379, 0x8E20],
+    (True, False): [
+        0x0000, 0x3448, 0x9BA7, 0x8BBB, 0x85E1, 0x3E8C, 0x451E, 0x18E6, 0x6B24, 0xE7AB, 0x3828, 0x814B,
+        0xD461, 0xF494, 0x2503, 0x691D, 0xFE8B, 0x9BA7, 0x8B17, 0x2920, 0x8B5F, 0x61B1, 0xD391, 0x7401,
+        0x2138, 0x129F, 0xB3A0, 0x2988, 0x23CA, 0xC0CB, 0x0C6C, 0xB329, 0xA0A1, 0x0A16, 0xA9D0],
+    (False, True): [
+        0x0000, 0x8BE6, 0xD8EC, 0xB87A, 0x42DC, 0xAA89, 0x83AF, 0x10E4, 0xE83E, 0x5C29, 0xAC76, 0x1C69,
+        0xA4B2, 0x5961, 0xB4D3, 0x2A50, 0xCB27, 0x5128, 0x7CDB, 0x7A14, 0xD5D2, 0x57D7, 0xE31D, 0xCE42,
+        0x648D, 0xBF2D, 0x653B, 0x190C, 0x9117, 0x9A97, 0xABFC, 0xE68E, 0x0DE7, 0x28A2, 0x1965],
+    (True, True): [
+        0x0000, 0x7EBF, 0x3ECE, 0x07A4, 0xCA52, 0x343B, 0x53F8, 0x8CD0, 0x9EAC, 0xD0C0, 0x150D, 0x5186,
+        0xD251, 0xA46F, 0x8435, 0xFA2E, 0x7EBD, 0x3C7D, 0x94E0, 0x3D5F, 0xA685, 0x4E47, 0xF045, 0xB483,
+        0x7A1F, 0xDEA2, 0x9642, 0xBF4B, 0x032F, 0x01D2, 0xDC86, 0x92A5, 0x183A, 0xB760, 0xA953],
+}
+
+
+class Bits:
+    """MSB-first bit writer"""
+
+    def __init__(self):
+        self.bits = []
+
+    def put(self, v, n):
+        self.bits += [(v >> i) & 1 for i in range(n - 1, -1, -1)]
+
+    def bytes(self):
+        b = self.bits + [0] * (-len(self.bits) % 8)
+        return bytes(int("".join(map(str, b[i:i + 8])), 2) for i in range(0, len(b), 8))
+
+
+def crc16_ccitt(crc, data, nbits=None):
+    """data MSB first; nbits limits the bits taken from data"""
+    nbits = len(data) * 8 if nbits is None else nbits
+    for i in range(nbits):
+        bit = (data[i >> 3] >> (7 - (i & 7))) & 1
+        crc = ((crc << 1) ^ 0x1021) if ((crc >> 15) ^ bit) & 1 else (crc << 1)
+        crc &= 0xFFFF
+    return crc
+
+
+def bit_reverse(b):
+    return int("{:08b}".format(b)[::-1], 2)
+
+
+def xn297_frame(addr, payload, scramble=False, enhanced=False, pid=0, ack=False):
+    """On-air bytes after the NRF preamble: 71 0F 55, address, [PCF], payload, CRC.
+    addr is MSB first as the XN297 is configured (and as the dump prints it)."""
+    al = len(addr)
+    body = Bits()
+    for b in reversed(addr):
+        body.put(b, 8)
+    if enhanced:
+        body.put((len(payload) << 3) | (pid << 1) | int(ack), 10)
+    for b in payload:
+        body.put(bit_reverse(b), 8)
+    nbits = len(body.bits)
+    data = bytearray(body.bytes())
+    if scramble:
+        for i in range(len(data)):
+            data[i] ^= XN297_SCRAMBLE[i]
+    crc = crc16_ccitt(0xB5D2, data, nbits)
+    crc ^= XN297_XOROUT[(scramble, enhanced)][al + len(payload) - 3]
+    out = Bits()
+    out.bits = [(data[i >> 3] >> (7 - (i & 7))) & 1 for i in range(nbits)]
+    out.put(crc, 16)
+    return XN297_PREAMBLE + out.bytes()
+
+
+def nrf_frame(addr, payload, crc_len=2):
+    """Plain NRF24L01 frame (static payload, no ESB header); addr as written to RX_ADDR_P0"""
+    data = bytes(reversed(addr)) + bytes(payload)
+    if crc_len == 2:
+        return data + crc16_ccitt(0xFFFF, data).to_bytes(2, "big")
+    if crc_len == 1:
+        c = 0xFF
+        for b in data:
+            c ^= b
+            for _ in range(8):
+                c = ((c << 1) ^ 0x07) & 0xFF if c & 0x80 else (c << 1) & 0xFF
+        return data + bytes([c])
+    return data
+
+
+def air_line(t_us, ch, rate, frame):
+    return "%d air %d %s %s" % (t_us, ch, rate, frame.hex().upper())
+
+
+def transmitter(addr, length, hops=(40,), start=1000, period=5000, count=None, end=None, per_hop=1,
+                nrf=False, crc=2, scramble=False, enhanced=False, seed=1):
+    """Yield (t_us, channel, frame, payload) for one transmitter: a new random
+    payload every period, moving to the next hop channel every per_hop frames.
+    Stops after count frames or at end us, whichever comes first."""
+    rnd = random.Random(seed)
+    i = 0
+    while (count is None or i < count) and (end is None or start + i * period < end):
+        payload = bytes(rnd.randrange(256) for _ in range(length))
+        if nrf:
+            frame = nrf_frame(addr, payload, crc)
+        else:
+            frame = xn297_frame(addr, payload, scramble, enhanced, pid=i & 3)
+        yield start + i * period, hops[(i // per_hop) % len(hops)], frame, payload
+        i += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--addr", default="C0FFEE", help="address, hex MSB first (3..5 bytes)")
+    ap.add_argument("--len", type=int, default=16, help="payload length")
+    ap.add_argument("--nrf", action="store_true", help="plain NRF24L01 frames instead of XN297")
+    ap.add_argument("--crc", type=int, default=2, choices=(0, 1, 2), help="NRF CRC bytes")
+    ap.add_argument("--scramble", action="store_true")
+    ap.add_argument("--enhanced", action="store_true")
+    ap.add_argument("--ch", default="40", help="channel, or hop table as 5,22,41,60")
+    ap.add_argument("--per-hop", type=int, default=1, help="frames sent on each hop channel")
+    ap.add_argument("--rate", default="1M", choices=("250K", "1M", "2M"))
+    ap.add_argument("--start", type=int, default=1000, help="first frame, us")
+    ap.add_argument("--period", type=int, default=5000, help="us between frames")
+    ap.add_argument("--count", type=int, default=200)
+    ap.add_argument("--seed", type=int, default=1, help="payload contents")
+    args = ap.parse_args()
+    hops = [int(c) for c in args.ch.split(",")]
+    for t, ch, frame, _ in transmitter(bytes.fromhex(args.addr), args.len, hops, args.start, args.period,
+                                       args.count, per_hop=args.per_hop, nrf=args.nrf, crc=args.crc,
+                                       scramble=args.scramble, enhanced=args.enhanced, seed=args.seed):
+        print(air_line(t, ch, args.rate, frame))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+End-to-end capture benchmark: virtual RC transmitters against the firmware
+running in the host simulation (env native, src/platform_native.cpp).
+
+A scenario (JSON, see bench/scenarios/) gives the CLI commands to run, the
+run length and the transmitters. Each transmitter has an address, bitrate,
+payload length, packet period, hop table and frame format. The harness
+writes the air script, runs the native program on it (the real
+XN297Dump_run/XN297Dump_step loop against the simulated NRF24L01 and clock)
+and reports:
+  capture    transmitted packets whose payload shows up in the output
+  detect     Auto mode: time to 'Packet detected'
+  phase 2    Auto mode: time to the end of RF channel identification, and
+             whether the channels kept match the hop table
+  phase 3    Auto mode: time to the end of the channel order, and whether
+             it matches the hop order
+  bytes/pkt  output bytes per captured packet
+Times are virtual seconds from the 'Initialized:' line of the run. The
+payload of every packet is random, so output lines map back to packets.
+
+  pio run -e native
+  xn297_scenario.py bench/scenarios/auto_hop4.json
+  xn297_scenario.py --json bench/scenarios/*.json > before.json
+"""
+import argparse
+import bisect
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from xn297_air import air_line, transmitter  # noqa: E402
+from xn297dump_decode import parse_record  # noqa: E402
+
+PAYLOAD = re.compile(r"(?:P(?:\(\d+\))?[:=]|OK:)((?: [0-9A-F]{2})+)")
+MARKERS = {
+    "start": "Initialized:",
+    "detect": "Packet detected",
+    "phase2": "Identifying RF channels order.",
+    "phase3": "Identifying Sticks and features.",
+}
+KEPT = re.compile(r"Keeping only RF channels with more than \d+ packets:([ \d*]*)")
+ORDER = re.compile(r"Channel order:\r?\n((?:\d+: +\d+us\r?\n)+)")
+SIM = re.compile(r"sim: .* (\d+) FIFO full.*\nsim: txq (\d+) bytes queued, (\d+) messages dropped")
+
+
+def build_script(sc, path):
+    """Air + CLI script; returns {payload: (transmitter index, send time)}"""
+    events, sent = [], {}
+    for line in sc.get("cli", []):
+        events.append((0, "0 cli " + line))
+    end = int(sc["duration_s"] * 1e6)
+    for n, tx in enumerate(sc["transmitters"]):
+        for t, ch, frame, payload in transmitter(
+                bytes.fromhex(tx["addr"]), tx["len"], tx.get("hops", [40]), tx.get("start_us", 0),
+                tx.get("period_us", 5000), end=end, per_hop=tx.get("per_hop", 1),
+                nrf=tx.get("nrf", False), crc=tx.get("crc", 2), scramble=tx.get("scramble", False),
+                enhanced=tx.get("enhanced", False), seed=tx.get("seed", n + 1)):
+            events.append((t, air_line(t, ch, tx.get("rate", "1M"), frame)))
+            sent[payload] = (n, t)
+    events.sort(key=lambda e: e[0])
+    with open(path, "w") as f:
+        f.write("".join(e[1] + "\n" for e in events))
+    return sent
+
+
+def run(program, sc):
+    with tempfile.TemporaryDirectory() as tmp:
+        script, timeline = os.path.join(tmp, "air.txt"), os.path.join(tmp, "timeline.txt")
+        sent = build_script(sc, script)
+        p = subprocess.run([program, "-s", script, "-T", timeline, "-t", str(int(sc["duration_s"] * 1e6))]
+                           + sc.get("sim_args", []), capture_output=True, check=True)
+        with open(timeline) as f:
+            stamps = [tuple(map(int, line.split())) for line in f]
+    return sent, p.stdout, stamps, p.stderr.decode("latin-1")
+
+
+def score(sc, sent, out, stamps, stderr):
+    offsets = [s[0] for s in stamps]
+
+    def when(offset):
+        i = bisect.bisect_left(offsets, offset + 1)
+        return stamps[min(i, len(stamps) - 1)][1] if stamps else 0
+
+    lens = sorted({len(k) for k in sent})
+    captured, marks, text = {}, {}, []
+    pos = 0
+    for chunk in out.split(b"\0"):
+        rec = parse_record(chunk) if chunk else None
+        if rec is not None:
+            hits = [(pos + len(chunk), rec["payload"])]
+        else:
+            s = chunk.decode("latin-1")
+            text.append(s)
+            hits = [(pos + m.end(), bytes.fromhex(m.group(1))) for m in PAYLOAD.finditer(s)]
+            for name, marker in MARKERS.items():
+                for m in re.finditer(re.escape(marker), s):
+                    if name == "start" or name not in marks:
+                        marks[name] = (when(pos + m.end()), pos + m.end())
+        for off, data in hits:
+            for n in lens:
+                if data[:n] in sent:
+                    captured.setdefault(data[:n], when(off))
+        pos += len(chunk) + 1
+
+    t0, start = marks.get("start", (0, 0))
+    pkts = {k for k, (_, t) in sent.items() if t >= t0}
+    got = pkts & captured.keys()
+    out_bytes = len(out) - start
+    r = {
+        "scenario": sc.get("name", ""),
+        "sent": len(pkts),
+        "captured": len(got),
+        "capture": len(got) / len(pkts) if pkts else 0.0,
+        "bytes_per_packet": out_bytes / len(got) if got else None,
+        "per_tx": [[sum(1 for k in got if sent[k][0] == n), sum(1 for k in pkts if sent[k][0] == n)]
+                   for n in range(len(sc["transmitters"]))],
+    }
+    for name in ("detect", "phase2", "phase3"):
+        r[name + "_s"] = (marks[name][0] - t0) / 1e6 if name in marks else None
+    whole = "".join(text)
+    hops = sc["transmitters"][0].get("hops", [40])
+    m = KEPT.search(whole)
+    if m:
+        r["channels"] = [int(c.rstrip("*")) for c in m.group(1).split()]
+        r["channels_ok"] = sorted(r["channels"]) == sorted(set(hops))
+    m = ORDER.search(whole)
+    if m:
+        r["order"] = [int(line.split(":")[0]) for line in m.group(1).split()[::2]]
+        i = hops.index(r["order"][0]) if r["order"][0] in hops else 0
+        r["order_ok"] = r["order"] == (hops[i:] + hops[:i])[:len(r["order"])] and len(r["order"]) == len(hops)
+    m = SIM.search(stderr)
+    if m:
+        r["fifo_full"], r["txq_dropped"] = int(m.group(1)), int(m.group(3))
+    return r
+
+
+def show(r):
+    def sec(v):
+        return "%8.3f s" % v if v is not None else "       --"
+
+    print("%s: %d/%d packets captured (%.1f%%)" % (r["scenario"], r["captured"], r["sent"], 100 * r["capture"]))
+    if len(r["per_tx"]) > 1:
+        print("  per transmitter " + ", ".join("%d/%d" % tuple(t) for t in r["per_tx"]))
+    print("  first detection %s" % sec(r["detect_s"]))
+    line = "  phase 2 done    %s" % sec(r["phase2_s"])
+    if "channels" in r:
+        line += "  channels %s (%s)" % (" ".join(map(str, r["channels"])), "match" if r["channels_ok"] else "MISMATCH")
+    print(line)
+    line = "  phase 3 done    %s" % sec(r["phase3_s"])
+    if "order" in r:
+        line += "  order %s (%s)" % (" ".join(map(str, r["order"])), "match" if r["order_ok"] else "MISMATCH")
+    print(line)
+    bpp = "%.1f" % r["bytes_per_packet"] if r["bytes_per_packet"] is not None else "--"
+    print("  output          %s bytes/packet, %s messages dropped, %s RX FIFO overflows" % (
+        bpp, r.get("txq_dropped", "?"), r.get("fifo_full", "?")))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("scenario", nargs="+")
+    ap.add_argument("--program", default=os.path.join(os.path.dirname(__file__), "..", ".pio", "build", "native", "program"))
+    ap.add_argument("--json", action="store_true", help="print the results as JSON")
+    args = ap.parse_args()
+    results = []
+    for path in args.scenario:
+        with open(path) as f:
+            sc = json.load(f)
+        sc.setdefault("name", os.path.splitext(os.path.basename(path))[0])
+        r = score(sc, *run(args.program, sc))
+        results.append(r)
+        if not args.json:
+            show(r)
+    if args.json:
+        json.dump(results, sys.stdout, indent=1)
+        print()
+
+
+if __name__ == "__main__":
+    main()
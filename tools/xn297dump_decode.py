@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+"""
+Decode the XN297Dump binary output stream ('out bin' on the CLI).
+
+Records are COBS-framed and 00-delimited, layout in include/dump_output.h.
+Chunks that are not valid records (CLI echo, status text) are passed
+through unchanged in text mode and dropped otherwise. Tokenized log
+records ('log tok', include/dump_log.h) are expanded back to text with
+the format table written by tools/gen_fmt_table.py at build time.
+
+  xn297dump_decode.py capture.bin                  # text, same lines as 'out text'
+  xn297dump_decode.py -f csv capture.bin > out.csv
+  xn297dump_decode.py -f pcap -o out.pcap capture.bin
+  xn297dump_decode.py --port /dev/ttyUSB0          # live, needs pyserial
+  xn297dump_decode.py --fmt-table .pio/build/stm32f103/dump_fmt.json capture.bin
+"""
+import argparse
+import json
+import re
+import struct
+import sys
+
+REC_FRAME = 0x01
+REC_LOG = 0x02
+F_CRC_OK, F_SCRAMBLE, F_ENHANCED, F_ACK = 0x01, 0x02, 0x04, 0x08
+HDR = struct.Struct("<BHIBBBBBBB")  # type seq time mode ch bitrate flags pid addr_len len
+MODE_NRF, MODE_XN297 = 4, 6
+BITRATES = {0: "250K", 1: "1M", 2: "2M"}
+LINKTYPE_USER0 = 147
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_record(chunk):
+    raw = cobs_decode(chunk)
+    if raw is None or len(raw) < HDR.size + 2:
+        return None
+    if crc16_ccitt(raw[:-2]) != struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+        return None
+    f = HDR.unpack_from(raw)
+    if f[0] != REC_FRAME or HDR.size + f[9] + 2 != len(raw):
+        return None
+    data = raw[HDR.size:HDR.size + f[9]]
+    return {
+        "seq": f[1], "time": f[2], "mode": f[3], "channel": f[4], "bitrate": f[5],
+        "flags": f[6], "offset": ((f[6] >> 4) ^ 8) - 8, "pid": f[7], "addr": data[:f[8]], "payload": data[f[8]:],
+        "raw": raw[:-2],
+    }
+
+
+def check_crc(chunk):
+    raw = cobs_decode(chunk)
+    if raw is None or len(raw) < 3:
+        return None
+    if crc16_ccitt(raw[:-2]) != struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+        return None
+    return raw[:-2]
+
+
+CONV = re.compile(r"%([-+ #0-9.]*)([lhz]*)([diuxXocs%])")
+
+
+def varint(raw, i):
+    v = shift = 0
+    while i < len(raw):
+        b = raw[i]
+        i += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            break
+    return v, i
+
+
+def expand_log(raw, table):
+    """DUMP_REC_LOG payload -> text, following the firmware's dump_log() encoding."""
+    fid, nl = struct.unpack_from("<IB", raw, 1)
+    fmt = table.get(fid)
+    if fmt is None:
+        return "<log %08X: not in format table>\r\n" % fid
+    i = 6
+
+    def arg(m):
+        nonlocal i
+        conv = m.group(3)
+        if conv == "%":
+            return "%"
+        if i >= len(raw):
+            return "?"  # not in the record (firmware before the text fallback)
+        if conv == "s":
+            n = raw[i]
+            v = raw[i + 1:i + 1 + n].decode("latin-1")
+            i += 1 + n
+        else:
+            v, i = varint(raw, i)
+            if conv in "di":
+                v = (v >> 1) ^ -(v & 1)
+        return ("%" + m.group(1) + conv) % v
+    text = CONV.sub(arg, fmt)
+    return text + ("\r\n" if nl else "")
+
+
+def load_fmt_table(path):
+    with open(path) as f:
+        return {int(k, 16): v for k, v in json.load(f).items()}
+
+
+def hexs(b):
+    return "".join(" %02X" % x for x in b)
+
+
+class TextFormatter:
+    """Rebuilds the firmware's text lines, including its inter-frame times."""
+
+    def __init__(self, out):
+        self.out = out
+        self.last_ok = 0
+        self.last_ch = None
+        self.last = 0
+
+    def frame(self, r):
+        t = r["time"]
+        if r["mode"] == MODE_NRF:
+            dt, self.last = (t - self.last) & 0xFFFFFFFF, t
+            line = "RX: %5uus C: %02X P:%s" % (dt, r["channel"], hexs(r["payload"]))
+        elif r["mode"] == MODE_XN297:
+            dt, self.last = (t - self.last) & 0xFFFFFFFF, t
+            if r["flags"] & F_CRC_OK:
+                line = "RX: %5uus OK:%s" % (dt, hexs(r["payload"]))
+            else:
+                line = "RX: %5uus  NOK" % dt
+        else:
+            dt = (t - self.last_ok) & 0xFFFFFFFF if r["channel"] == self.last_ch else 0
+            self.last_ch = r["channel"]
+            if not r["flags"] & F_CRC_OK:
+                line = "RX: %5uus C=%d Bad CRC" % (dt, r["channel"])
+            else:
+                self.last_ok = t
+                line = "RX: %5uus C=%d " % (dt, r["channel"])
+                if r["offset"]:
+                    line += "Offset=%d " % r["offset"]
+                if r["flags"] & F_ENHANCED:
+                    line += "Enhanced pid=%d " % r["pid"]
+                    if r["flags"] & F_ACK:
+                        line += "ack "
+                line += "S=%s A=%s" % ("Y" if r["flags"] & F_SCRAMBLE else "N", hexs(r["addr"]))
+                line += " P(%d)=%s" % (len(r["payload"]), hexs(r["payload"]))
+        self.out.write(line + "\r\n")
+
+    def text(self, chunk):
+        self.out.write(chunk.decode("latin-1"))
+
+
+class CsvFormatter:
+    def __init__(self, out):
+        self.out = out
+        out.write("seq,time_us,mode,channel,bitrate,crc_ok,scrambled,enhanced,ack,bit_offset,pid,address,payload\n")
+
+    def frame(self, r):
+        fl = r["flags"]
+        self.out.write("%d,%d,%d,%d,%s,%d,%d,%d,%d,%d,%d,%s,%s\n" % (
+            r["seq"], r["time"], r["mode"], r["channel"], BITRATES.get(r["bitrate"], r["bitrate"]),
+            fl & F_CRC_OK and 1, fl & F_SCRAMBLE and 1, fl & F_ENHANCED and 1, fl & F_ACK and 1,
+            r["offset"], r["pid"], r["addr"].hex().upper(), r["payload"].hex().upper()))
+
+    def text(self, chunk):
+        pass
+
+
+class PcapFormatter:
+    """One pcap packet per record (header included), LINKTYPE_USER0."""
+
+    def __init__(self, out):
+        self.out = out
+        self.wraps = 0
+        self.prev = 0
+        out.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, LINKTYPE_USER0))
+
+    def frame(self, r):
+        if r["time"] < self.prev:
+            self.wraps += 1
+        self.prev = r["time"]
+        us = (self.wraps << 32) + r["time"]
+        raw = r["raw"]
+        self.out.write(struct.pack("<IIII", us // 1000000, us % 1000000, len(raw), len(raw)))
+        self.out.write(raw)
+
+    def text(self, chunk):
+        pass
+
+
+def chunks(stream):
+    buf = bytearray()
+    while True:
+        data = stream.read(1)
+        if not data:
+            break
+        if data[0] == 0:
+            if buf:
+                yield bytes(buf)
+                buf.clear()
+        else:
+            buf += data
+    if buf:
+        yield bytes(buf)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", nargs="?", default="-", help="capture file, '-' for stdin")
+    ap.add_argument("--port", help="read live from a serial port instead (pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("-f", "--format", choices=("text", "csv", "pcap"), default="text")
+    ap.add_argument("-o", "--output", default="-")
+    ap.add_argument("--fmt-table", help="dump_fmt.json from the firmware build, for 'log tok' records")
+    args = ap.parse_args()
+
+    if args.port:
+        import serial
+        src = serial.Serial(args.port, args.baud)
+    elif args.input == "-":
+        src = sys.stdin.buffer
+    else:
+        src = open(args.input, "rb")
+
+    if args.format == "pcap":
+        out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+        fmt = PcapFormatter(out)
+    else:
+        out = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+        fmt = TextFormatter(out) if args.format == "text" else CsvFormatter(out)
+
+    table = load_fmt_table(args.fmt_table) if args.fmt_table else {}
+    expect = None
+    lost = 0
+    for chunk in chunks(src):
+        r = parse_record(chunk)
+        if r is None:
+            raw = check_crc(chunk)
+            if raw is not None and raw[0] == REC_LOG and len(raw) >= 6:
+                fmt.text(expand_log(raw, table).encode("latin-1"))
+            else:
+                fmt.text(chunk)
+            continue
+        if expect is not None and r["seq"] != expect:
+            lost += (r["seq"] - expect) & 0xFFFF
+        expect = (r["seq"] + 1) & 0xFFFF
+        fmt.frame(r)
+        out.flush()
+    if lost:
+        sys.stderr.write("%d records lost (sequence gaps)\n" % lost)
+
+
+if __name__ == "__main__":
+    main()